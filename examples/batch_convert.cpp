@@ -0,0 +1,341 @@
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <semaphore>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <halcyon/image.hpp>
+#include <halcyon/main.hpp>
+#include <halcyon/utility/thread_pool.hpp>
+
+// batch_convert.cpp:
+// Converts a directory of images in parallel, optionally resizing and
+// premultiplying them, and packing the results into an atlas.
+
+namespace
+{
+    namespace fs = std::filesystem;
+
+    struct options
+    {
+        fs::path input, output;
+
+        // Zero means "keep the original size".
+        hal::pixel::point size { 0, 0 };
+        float             scale { 1.0f };
+
+        bool premultiply { false };
+
+        std::string_view format { "png" };
+        std::string_view atlas;
+
+        std::size_t jobs { 0 };
+        std::size_t in_flight { 16 };
+    };
+
+    constexpr hal::pixel_t atlas_width { 2048 };
+
+    constexpr std::string_view usage {
+        " <input dir> <output dir> [options]\n"
+        "  --resize WxH      Resize every image to a fixed size.\n"
+        "  --scale F         Scale every image by a factor.\n"
+        "  --premultiply     Premultiply colors by alpha.\n"
+        "  --format F        Output format: png (default), qoi or bmp.\n"
+        "  --atlas NAME      Pack all images into NAME.<format> and list them in NAME.txt.\n"
+        "  --jobs N          Amount of worker threads (default: one per core).\n"
+        "  --in-flight N     Maximum amount of images in memory at once (default: 16).\n"
+    };
+
+    template <typename T>
+    bool parse_number(std::string_view str, T& out)
+    {
+        const auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), out);
+
+        return ec == std::errc {} && ptr == str.data() + str.size();
+    }
+
+    bool parse(std::span<char*> args, options& opt)
+    {
+        if (args.size() < 3)
+            return false;
+
+        opt.input  = args[1];
+        opt.output = args[2];
+
+        for (std::size_t i { 3 }; i < args.size(); ++i)
+        {
+            const std::string_view arg { args[i] };
+
+            if (arg == "--premultiply")
+            {
+                opt.premultiply = true;
+                continue;
+            }
+
+            // Everything else takes a value.
+            if (i + 1 == args.size())
+                return false;
+
+            const std::string_view val { args[++i] };
+
+            if (arg == "--resize")
+            {
+                const std::size_t x { val.find('x') };
+
+                if (x == std::string_view::npos || !parse_number(val.substr(0, x), opt.size.x) || !parse_number(val.substr(x + 1), opt.size.y))
+                    return false;
+
+                // Zero would mean "keep the original size" for this axis only, which resizing can't do.
+                if (opt.size.x <= 0 || opt.size.y <= 0)
+                    return false;
+            }
+
+            else if (arg == "--scale")
+            {
+                if (!parse_number(val, opt.scale) || opt.scale <= 0.0f)
+                    return false;
+            }
+
+            else if (arg == "--format")
+            {
+                if (val != "png" && val != "qoi" && val != "bmp")
+                    return false;
+
+                opt.format = val;
+            }
+
+            else if (arg == "--atlas")
+                opt.atlas = val;
+
+            else if (arg == "--jobs")
+            {
+                if (!parse_number(val, opt.jobs))
+                    return false;
+            }
+
+            else if (arg == "--in-flight")
+            {
+                if (!parse_number(val, opt.in_flight) || opt.in_flight == 0)
+                    return false;
+            }
+
+            else
+                return false;
+        }
+
+        return true;
+    }
+
+    hal::surface process(hal::surface surf, const options& opt)
+    {
+        hal::pixel::point size { opt.size };
+
+        // Tiny images scaled down still keep a pixel in each direction.
+        if (size == hal::pixel::point { 0, 0 })
+            size = { std::max(static_cast<hal::pixel_t>(surf.size().x * opt.scale), hal::pixel_t(1)), std::max(static_cast<hal::pixel_t>(surf.size().y * opt.scale), hal::pixel_t(1)) };
+
+        // Lanczos keeps downscaled images sharp without aliasing.
+        if (size != surf.size())
+            surf = surf.resize(size, hal::resample_filter::lanczos3, true);
+
+        if (opt.premultiply)
+            ::SDL_PremultiplySurfaceAlpha(surf.get(), false);
+
+        return surf;
+    }
+
+    bool save(const hal::surface& surf, const fs::path& path, std::string_view format)
+    {
+        if (format == "qoi")
+            return hal::image::save::qoi(surf, path);
+
+        if (format == "bmp")
+            return surf.save(path);
+
+        return hal::image::save::png(surf, path);
+    }
+
+    struct atlas_entry
+    {
+        std::string       name;
+        hal::surface      surf;
+        hal::pixel::point pos;
+    };
+
+    // Place images on shelves, tallest first, wrapping at a fixed width.
+    // Returns the size of the atlas.
+    hal::pixel::point pack(std::vector<atlas_entry>& entries)
+    {
+        std::ranges::sort(entries, std::greater {}, [](const atlas_entry& e)
+            { return e.surf.size().y; });
+
+        hal::pixel::point cursor { 0, 0 }, ret { 0, 0 };
+        hal::pixel_t      shelf_height { 0 };
+
+        for (atlas_entry& e : entries)
+        {
+            const hal::pixel::point size { e.surf.size() };
+
+            if (cursor.x > 0 && cursor.x + size.x > atlas_width)
+            {
+                cursor = { 0, cursor.y + shelf_height };
+                shelf_height = 0;
+            }
+
+            e.pos        = cursor;
+            cursor.x    += size.x;
+            shelf_height = std::max(shelf_height, size.y);
+
+            ret = { std::max(ret.x, cursor.x), std::max(ret.y, cursor.y + shelf_height) };
+        }
+
+        return ret;
+    }
+
+    bool write_atlas(std::vector<atlas_entry>& entries, const options& opt)
+    {
+        const hal::pixel::point size { pack(entries) };
+
+        hal::surface atlas { size, hal::pixel::format::rgba32 };
+        atlas.fill(hal::colors::transparent);
+
+        const fs::path base { opt.output / opt.atlas };
+
+        std::ofstream list { fs::path { base }.replace_extension(".txt") };
+
+        for (atlas_entry& e : entries)
+        {
+            // Copy pixels as they are, instead of blending them onto transparency.
+            e.surf.blend(hal::blend_mode::none);
+
+            if (!e.surf.blit(atlas).to(e.pos).blit())
+                return false;
+
+            list << e.name << ' ' << e.pos.x << ' ' << e.pos.y << ' ' << e.surf.size().x << ' ' << e.surf.size().y << '\n';
+        }
+
+        return save(atlas, fs::path { base }.replace_extension(opt.format), opt.format) && list.good();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    options opt;
+
+    if (!parse({ argv, static_cast<std::size_t>(argc) }, opt))
+    {
+        std::cout << "Usage: " << argv[0] << usage;
+        return EXIT_FAILURE;
+    }
+
+    std::error_code ec;
+    fs::create_directories(opt.output, ec);
+
+    std::vector<fs::path> files;
+
+    for (const fs::directory_entry& e : fs::recursive_directory_iterator { opt.input, ec })
+    {
+        if (e.is_regular_file())
+            files.push_back(e.path());
+    }
+
+    // The main thread only queues files, so every core gets a worker by default.
+    hal::thread_pool pool { opt.jobs != 0 ? opt.jobs : std::max(std::thread::hardware_concurrency(), 1u) };
+
+    // Loading stops once this many images are being worked on, so memory stays bounded.
+    std::counting_semaphore<> slots { static_cast<std::ptrdiff_t>(opt.in_flight) };
+
+    std::atomic<std::size_t> converted { 0 }, failed { 0 }, skipped { 0 };
+
+    std::mutex               mutex;
+    std::vector<atlas_entry> atlas;
+
+    for (const fs::path& path : files)
+    {
+        slots.acquire();
+
+        pool.push([&, path]
+            {
+                hal::surface surf { hal::image::load(path) };
+
+                // Not every file in the directory is necessarily an image.
+                if (!surf.valid())
+                {
+                    ++skipped;
+
+                    std::lock_guard _ { mutex };
+                    std::cout << "Skipping " << path.string() << '\n';
+                }
+
+                else
+                {
+                    surf = process(std::move(surf), opt);
+
+                    // Throwing here would end the whole program from a worker thread.
+                    std::error_code rel_ec;
+                    const fs::path  rel { fs::relative(path, opt.input, rel_ec) };
+
+                    if (!surf.valid() || rel_ec)
+                    {
+                        ++failed;
+
+                        std::lock_guard _ { mutex };
+                        std::cout << "Could not convert " << path.string() << '\n';
+                    }
+
+                    else if (!opt.atlas.empty())
+                    {
+                        std::lock_guard _ { mutex };
+                        atlas.push_back({ rel.generic_string(), std::move(surf), {} });
+
+                        ++converted;
+                    }
+
+                    else
+                    {
+                        fs::path dst { opt.output / rel };
+
+                        std::error_code dir_ec;
+                        fs::create_directories(dst.parent_path(), dir_ec);
+
+                        if (save(surf, dst.replace_extension(opt.format), opt.format))
+                            ++converted;
+
+                        else
+                        {
+                            ++failed;
+
+                            std::lock_guard _ { mutex };
+                            std::cout << "Could not write " << dst.string() << '\n';
+                        }
+                    }
+                }
+
+                slots.release();
+            });
+    }
+
+    pool.wait();
+
+    // Packed images have to stay in memory until the atlas is written.
+    if (!atlas.empty() && !write_atlas(atlas, opt))
+    {
+        std::cout << "Could not write atlas\n";
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "Converted " << converted << " of " << files.size() - skipped << " images";
+
+    if (skipped != 0)
+        std::cout << ", skipped " << skipped << " other files";
+
+    std::cout << '\n';
+
+    return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
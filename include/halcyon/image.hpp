@@ -10,6 +10,8 @@
 
 namespace hal
 {
+    class thread_pool;
+
     namespace image
     {
         enum class load_format : std::uint8_t
@@ -36,7 +38,7 @@ namespace hal
             unknown
         };
 
-        // Load an image, automatically deducing the format.
+        // Load an image, automatically deducing the format from its first bytes.
         [[nodiscard]] surface load(accessor src);
 
         // Load an image, knowing the format in advance.
@@ -47,9 +49,17 @@ namespace hal
             bool png(ref<const surface> surf, outputter dst);
             bool jpg(ref<const surface> surf, outputter dst, std::uint8_t quality = 90);
             bool avif(ref<const surface> surf, outputter dst, std::uint8_t quality = 90);
+
+            // Encoded by Halcyon itself, since SDL_image can only load QOI images.
+            bool qoi(ref<const surface> surf, outputter dst);
+
+            // Encode strips of rows on a thread pool (and the calling thread), writing
+            // each one as soon as all previous ones have been written.
+            // Do not call this from within a task running on the same pool.
+            bool qoi(ref<const surface> surf, outputter dst, thread_pool& pool);
         }
 
-        // Check an image's format.
+        // Check an image's format by its signature, reading the first bytes only once.
         // This modifies the accessor, but ultimately sets it back where it was.
         load_format query(const accessor& src);
 
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <halcyon/video/types.hpp>
+
+#include <SDL3/SDL_surface.h>
+
+#include <concepts>
+
+// internal/convert.hpp:
+// Specialized pixel format conversions, used by `surface::convert()`.
+
+namespace hal::detail
+{
+    // Convert every pixel of a surface into another one of the same size.
+    // Returns false if the conversion can't be done, in which case SDL has to do it.
+    using convert_func = bool (*)(const SDL_Surface& src, SDL_Surface& dst);
+
+    // A fast path for converting from one pixel format to another.
+    // Specializations provide a static `convert` function matching `convert_func`;
+    // all other pairs of formats are converted by SDL.
+    template <pixel::format From, pixel::format To>
+    struct fast_convert
+    {
+    };
+
+    template <pixel::format From, pixel::format To>
+    concept has_fast_convert = requires {
+        { &fast_convert<From, To>::convert } -> std::convertible_to<convert_func>;
+    };
+
+    template <>
+    struct fast_convert<pixel::format::rgba32, pixel::format::argb8888>
+    {
+        static bool convert(const SDL_Surface& src, SDL_Surface& dst);
+    };
+
+    template <>
+    struct fast_convert<pixel::format::argb8888, pixel::format::rgba32>
+    {
+        static bool convert(const SDL_Surface& src, SDL_Surface& dst);
+    };
+
+    template <>
+    struct fast_convert<pixel::format::rgb24, pixel::format::rgba32>
+    {
+        static bool convert(const SDL_Surface& src, SDL_Surface& dst);
+    };
+
+    template <>
+    struct fast_convert<pixel::format::rgba32, pixel::format::rgb565>
+    {
+        static bool convert(const SDL_Surface& src, SDL_Surface& dst);
+    };
+
+    // Requires the source surface to have a palette.
+    template <>
+    struct fast_convert<pixel::format::index8, pixel::format::rgba32>
+    {
+        static bool convert(const SDL_Surface& src, SDL_Surface& dst);
+    };
+
+    // Get the fast path for a pair of formats known only at runtime, if there is one.
+    convert_func find_convert(pixel::format from, pixel::format to);
+}
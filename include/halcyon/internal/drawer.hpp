@@ -7,10 +7,20 @@
 #include <halcyon/internal/resource.hpp>
 #include <halcyon/types/result.hpp>
 
+#include <cmath>
 #include <limits>
 
 namespace hal::detail
 {
+    // The bounding box of a rectangle rotated around its center by any angle.
+    template <typename T>
+    rectangle<T> rotated_bounds(const rectangle<T>& r)
+    {
+        const T diag { static_cast<T>(std::ceil(std::hypot(r.size.x, r.size.y))) };
+
+        return { r.pos.x - (diag - r.size.x) / 2, r.pos.y - (diag - r.size.y) / 2, diag, diag };
+    }
+
     // A base drawer class, implementing the builder method for drawing textures.
     // Designed to be used as an rvalue - all functions should only be called once.
     // It's possible to store it, but be careful of the possible pitfalls this enables.
@@ -47,6 +57,7 @@ namespace hal::detail
             , m_drawDst { dst }
             , m_posSrc { unset_pos(), 0, 0, 0 }
             , m_posDst { tag::as_size, get_point(src->size()) }
+            , m_cullArea { unset_pos(), 0, 0, 0 }
         {
         }
 
@@ -101,6 +112,15 @@ namespace hal::detail
             return get_this();
         }
 
+        // Skip the operation if the destination lies entirely outside of an area,
+        // i.e. the visible part of the render target. Can be called at any time,
+        // since the check is done with the final destination.
+        [[nodiscard]] this_ref cull(const pos_rect& area)
+        {
+            m_cullArea = area;
+            return get_this();
+        }
+
         // Access the source rectangle.
         pos_rect& src()
         {
@@ -131,9 +151,18 @@ namespace hal::detail
             return static_cast<this_ref>(*this);
         }
 
+        // Whether culling is enabled and the drawn area lies outside of the culling area.
+        bool culled(const pos_rect& bounds) const
+        {
+            return m_cullArea.pos.x != unset_pos() && m_posDst.pos.x != unset_pos() && !(bounds | m_cullArea);
+        }
+
         ref<Src> m_drawSrc;
         ref<Dst> m_drawDst;
 
         pos_rect m_posSrc, m_posDst;
+
+        // Culling is disabled if the position is unset.
+        pos_rect m_cullArea;
     };
 }
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <halcyon/video/types.hpp>
+
+#include <SDL3/SDL_iostream.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// internal/qoi.hpp:
+// An encoder for the Quite OK Image format, which SDL_image can only load,
+// and a decoder that doesn't need the whole image in memory.
+
+namespace hal
+{
+    class surface;
+    class thread_pool;
+
+    namespace detail
+    {
+        // Encode RGBA32 pixels as a complete QOI image.
+        std::vector<std::uint8_t> encode_qoi(const std::uint8_t* pixels, pixel::point size, int pitch);
+
+        // Encode strips of rows in parallel. Every strip starts from the last pixel of the
+        // previous one, so the result is a regular QOI image, if slightly larger.
+        // Do not call this from within a task running on the same pool.
+        std::vector<std::uint8_t> encode_qoi(const std::uint8_t* pixels, pixel::point size, int pitch, thread_pool& pool);
+
+        // Encode a surface, converting it to RGBA32 first if needed.
+        // Returns an empty vector if the conversion fails.
+        std::vector<std::uint8_t> encode_qoi(const surface& surf);
+        std::vector<std::uint8_t> encode_qoi(const surface& surf, thread_pool& pool);
+
+        // Encode a surface straight into a stream. In parallel, every strip is written
+        // once it and all previous ones are done, then freed, so the whole encoded image
+        // is never held in memory.
+        bool write_qoi(const surface& surf, SDL_IOStream* dst);
+        bool write_qoi(const surface& surf, SDL_IOStream* dst, thread_pool& pool);
+
+        // Decodes QOI images a few rows at a time, reading the stream in small chunks.
+        class qoi_decoder
+        {
+        public:
+            // Read the header. The stream must outlive the decoder.
+            qoi_decoder(SDL_IOStream* src);
+
+            // Whether the header was valid and all rows so far have been decoded.
+            bool valid() const;
+
+            pixel::point size() const;
+
+            // Decode the next rows as RGBA32 pixels.
+            bool read(std::uint8_t* dst, int pitch, pixel_t rows);
+
+        private:
+            // Make sure that at least a certain amount of bytes is buffered.
+            bool fill(std::size_t needed);
+
+            SDL_IOStream* m_src;
+
+            std::vector<std::uint8_t> m_buffer;
+            std::size_t               m_pos, m_end;
+
+            pixel::point m_size;
+            pixel_t      m_rowsLeft;
+
+            std::array<std::array<std::uint8_t, 4>, 64> m_index;
+            std::array<std::uint8_t, 4>                 m_prev;
+            std::uint8_t                                m_run;
+
+            bool m_valid;
+        };
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <halcyon/video/renderer.hpp>
+
+// internal/render_stats.hpp:
+// Counting of renderer statistics; compiled out unless HAL_RENDERER_STATS is defined.
+
+namespace hal::detail
+{
+    // Per-renderer bookkeeping, owned by the renderer's properties.
+    struct render_stats
+    {
+        renderer::statistics values;
+
+        // The texture used by the previous copy, for counting binds.
+        const SDL_Texture* last_texture;
+    };
+
+    // Get (or lazily create) the statistics of a renderer.
+    // Returns nullptr if statistics are disabled or the renderer is invalid.
+    render_stats* stats_of(SDL_Renderer* rnd);
+
+    // A draw call which submits an amount of primitives.
+    inline void count_draw([[maybe_unused]] SDL_Renderer* rnd, [[maybe_unused]] std::size_t primitives)
+    {
+        if constexpr (compile_settings::renderer_stats)
+        {
+            if (render_stats* s { stats_of(rnd) })
+            {
+                ++s->values.draw_calls;
+                s->values.primitives += primitives;
+            }
+        }
+    }
+
+    // A draw call which uses a texture.
+    inline void count_copy([[maybe_unused]] SDL_Renderer* rnd, [[maybe_unused]] const SDL_Texture* tx, [[maybe_unused]] std::size_t primitives = 1)
+    {
+        if constexpr (compile_settings::renderer_stats)
+        {
+            if (render_stats* s { stats_of(rnd) })
+            {
+                ++s->values.draw_calls;
+                s->values.primitives += primitives;
+
+                if (tx != nullptr && tx != s->last_texture)
+                {
+                    ++s->values.texture_binds;
+                    s->last_texture = tx;
+                }
+            }
+        }
+    }
+
+    // Call before switching to a target. Setting the current target again isn't a switch.
+    inline void count_target_switch([[maybe_unused]] SDL_Renderer* rnd, [[maybe_unused]] const SDL_Texture* target)
+    {
+        if constexpr (compile_settings::renderer_stats)
+        {
+            if (render_stats* s { stats_of(rnd) }; s != nullptr && ::SDL_GetRenderTarget(rnd) != target)
+                ++s->values.target_switches;
+        }
+    }
+
+    inline void count_upload([[maybe_unused]] SDL_Renderer* rnd, [[maybe_unused]] std::size_t bytes)
+    {
+        if constexpr (compile_settings::renderer_stats)
+        {
+            if (render_stats* s { stats_of(rnd) })
+                s->values.bytes_uploaded += bytes;
+        }
+    }
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+// internal/simd.hpp:
+// Support for hand-written vector kernels, chosen at runtime via `hal::cpu`.
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define HAL_SIMD_X86
+    #include <immintrin.h>
+
+    // GCC and Clang need to be told which functions may use which instructions;
+    // MSVC allows intrinsics anywhere.
+    #if defined(__GNUC__) || defined(__clang__)
+        #define HAL_TARGET_SSE2  __attribute__((target("sse2")))
+        #define HAL_TARGET_SSSE3 __attribute__((target("ssse3")))
+        #define HAL_TARGET_AVX   __attribute__((target("avx")))
+    #else
+        #define HAL_TARGET_SSE2
+        #define HAL_TARGET_SSSE3
+        #define HAL_TARGET_AVX
+    #endif
+#endif
@@ -10,6 +10,7 @@
 #include <SDL3/SDL_surface.h>
 
 #include <span>
+#include <vector>
 
 // surface.hpp:
 // A software bitmap, from which textures are created.
@@ -20,6 +21,7 @@ namespace hal
 {
     // Forward definitions for helper classes.
     class blitter;
+    class thread_pool;
 
     class surface : public detail::resource<SDL_Surface, ::SDL_DestroySurface>
     {
@@ -84,6 +86,20 @@ namespace hal
         // memory after converting to a texture.
         surface resize(pixel::point sz, scale_mode sm = default_scale_mode()) const;
 
+        // Get a resized copy of the surface, scaled in parallel.
+        // See `blitter::scaled(scale_mode, thread_pool&)`.
+        surface resize(pixel::point sz, scale_mode sm, thread_pool& pool) const;
+
+        // Get a resized copy of the surface using a separable filter, which samples every
+        // covered source pixel when downscaling. Gamma-correct resizing filters in linear
+        // light, which keeps fine detail from darkening, at a small cost.
+        // The result is always in the default pixel format.
+        surface resize(pixel::point sz, resample_filter rf, bool gamma_correct = false) const;
+
+        // Build a chain of mipmaps, each level half the size of the previous one
+        // (rounded down), down to 1x1. The surface itself is not included.
+        std::vector<surface> build_mips(resample_filter rf = resample_filter::box, bool gamma_correct = false) const;
+
         // Whether the surface must be locked before reading/writing pixels.
         bool must_lock() const;
 
@@ -125,6 +141,15 @@ namespace hal
 
         bool blit() const;
         bool scaled(scale_mode sm) const;
+
+        // Split the destination into horizontal bands, blitted by a thread pool (and the
+        // calling thread). Destinations too short to be worth it are blitted directly.
+        // With non-integer scale factors, rows at band edges may be sampled slightly
+        // differently than in a single blit.
+        // Do not call these from within a task running on the same pool.
+        bool blit(thread_pool& pool) const;
+        bool scaled(scale_mode sm, thread_pool& pool) const;
+
         bool tiled() const;
         bool tiled_scale(float scale, scale_mode sm) const;
         bool nine_grid(pixel_t width_left, pixel_t width_right, pixel_t height_top, pixel_t height_bottom, float scale, scale_mode sm) const;
@@ -2,9 +2,16 @@
 
 #include <halcyon/internal/iostream.hpp>
 #include <halcyon/surface.hpp>
+#include <halcyon/video/texture.hpp>
 
 #include <SDL3_ttf/SDL_ttf.h>
 
+#include <future>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
 // ttf.hpp:
 // SDL_ttf wrappers for font loading and text rendering.
 
@@ -21,6 +28,35 @@ namespace hal
         class context;
     }
 
+    class font;
+    class thread_pool;
+
+    // A font file loaded into memory once, from which fonts of any size can be made.
+    // Every font reads from the same bytes, which stay alive for as long as any of
+    // them does, so the face itself can be destroyed right after making fonts.
+    class font_face
+    {
+    public:
+        font_face() = default;
+
+        // Read the whole font file.
+        font_face(accessor src);
+
+        // Get the size of the font file, in bytes.
+        std::size_t size() const;
+
+        bool valid() const;
+
+    private:
+        friend class font;
+
+        // Open a stream over the shared data that keeps it alive until closed.
+        SDL_IOStream* open() const;
+
+        std::shared_ptr<const std::byte> m_data;
+        std::size_t                      m_size { 0 };
+    };
+
     class font : public detail::resource<TTF_Font, &::TTF_CloseFont>
     {
     public:
@@ -28,9 +64,12 @@ namespace hal
 
         font() = default;
 
-        // [private] Fonts are loaded with ttf::context::load().
+        // [private] Fonts are loaded with ttf::context::make_font().
         font(accessor src, pt_t size, pass_key<ttf::context>);
 
+        // [private] Fonts are loaded with ttf::context::make_font().
+        font(const font_face& face, pt_t size, pass_key<ttf::context>);
+
         // Rendering functions: text.
 
         [[nodiscard]] surface render_solid(std::string_view text, color fg) const;
@@ -52,6 +91,24 @@ namespace hal
         [[nodiscard]] surface render_blended(char32_t glyph, color fg) const;
         [[nodiscard]] surface render_lcd(char32_t glyph, color fg, color bg) const;
 
+        // Rasterize glyphs into the font's cache ahead of time, so that using them for the
+        // first time in surface rendering (i.e. `render_blended()`) doesn't cause a hitch.
+        // Text engines keep atlases of their own; warm those up via the engine.
+        // Glyphs the font doesn't have are skipped. Returns the amount of glyphs cached.
+        std::size_t warm_up(std::u32string_view glyphs) const;
+
+        // Change the point size in place, keeping the parsed font.
+        // This clears the glyph cache, so prefer separate fonts for sizes used
+        // side by side, and this for sizes that change over time (i.e. zooming).
+        bool size(pt_t size);
+        pt_t size() const;
+
+        // Render glyphs as signed distance fields instead of coverage, storing the
+        // distance to the outline in alpha. Use with `sdf_text` for scalable text.
+        // This clears the glyph cache.
+        bool sdf(bool enable);
+        bool sdf() const;
+
         pixel_t height() const;
         pixel_t skip() const;
 
@@ -86,17 +143,41 @@ namespace hal
 
             // Font loading function.
             [[nodiscard]] font make_font(accessor data, font::pt_t size) const;
+
+            // Make a font from an already loaded face, sharing its data.
+            [[nodiscard]] font make_font(const font_face& face, font::pt_t size) const;
         };
 
         static_assert(std::is_empty_v<context>);
 
         bool initialized();
+
+        // Warm up several fonts on a thread pool, one task per font. A font must not be
+        // used elsewhere until its future is ready, but different fonts can be warmed
+        // up and used concurrently. Each future holds the amount of glyphs cached.
+        [[nodiscard]] std::vector<std::future<std::size_t>> warm_up(std::span<const ref<const font>> fonts, std::u32string_view glyphs, thread_pool& pool);
+
+        // Character sets to warm fonts up with.
+        namespace charset
+        {
+            // Printable ASCII characters.
+            std::u32string ascii();
+
+            // Printable ASCII and Latin-1 Supplement characters.
+            std::u32string latin1();
+
+            // Every distinct character in a list of UTF-8 strings (i.e. localized UI text), sorted.
+            std::u32string from(std::span<const std::string_view> strings);
+        }
     }
 
     class text;
 
     namespace detail
     {
+        // Lay out text made of glyphs, so that an engine adds them to its atlas.
+        std::size_t warm_up_engine(TTF_TextEngine* eng, ref<const font> f, std::u32string_view glyphs);
+
         template <auto Creator, auto Deleter>
         class engine_base : public resource<TTF_TextEngine, Deleter>
         {
@@ -112,6 +193,16 @@ namespace hal
 
         public:
             text make_text(ref<const font> f, std::string_view text) const;
+
+            // Fill the engine's glyph atlas for a font ahead of time, so that text using
+            // the glyphs (i.e. chat or localized UI) doesn't cause a hitch when first drawn.
+            // Like any use of the engine, call this on the thread that owns it (for renderer
+            // engines, the renderer's). Glyphs the font doesn't have are skipped.
+            // Returns the amount of glyphs laid out, or zero if that failed.
+            std::size_t warm_up(ref<const font> f, std::u32string_view glyphs) const
+            {
+                return warm_up_engine(this->get(), f, glyphs);
+            }
         };
     }
 
@@ -151,7 +242,99 @@ namespace hal
 
         result<pixel::point> size() const;
 
+        // Get the current string.
+        std::string_view str() const;
+
+        // Editing functions. These change the string in place, so that only the
+        // affected parts are laid out again, instead of the whole text being recreated.
+        // Offsets and lengths are in bytes of UTF-8; they're moved to the nearest
+        // character boundary, and -1 means "until the end".
+
+        bool set(std::string_view str);
+        bool append(std::string_view str);
+        bool insert(int offset, std::string_view str);
+        bool erase(int offset, int length = -1);
+
+        // Get/set the color of the text. This doesn't require laying it out again.
+        result<hal::color> color() const;
+        bool               color(hal::color c);
+
+        // Get/set the width at which lines are wrapped. Zero only wraps on newlines.
+        result<pixel_t> wrap_width() const;
+        bool            wrap_width(pixel_t width);
+
     private:
         text(TTF_TextEngine* eng, ref<const font> f, std::string_view str);
     };
+
+    // Text rendered once as a signed distance field at its font's size, from which
+    // sharp textures of any scale are resolved on the CPU. The most recently used
+    // scales are kept as textures, so animating between a few of them is cheap.
+    // Other scales are resolved into the least recently used texture, which is only
+    // reallocated when it's too small. Using another renderer clears the cache.
+    class sdf_text
+    {
+    public:
+        // Sizes and offsets are in pixels of the font's size. Outlines and shadows can
+        // only extend as far as the field does, which is `spread` pixels.
+        struct style
+        {
+            color fill { colors::white };
+
+            color outline { colors::transparent };
+            float outline_width { 0.0f };
+
+            color        shadow { colors::transparent };
+            coord::point shadow_offset { 0.0f, 0.0f };
+            float        shadow_softness { 1.0f };
+        };
+
+        // How far from the outline distances are stored (FreeType's default).
+        static constexpr float spread { 8.0f };
+
+        sdf_text() = default;
+
+        // Render text with a font that has SDF enabled.
+        sdf_text(ref<const font> f, std::string_view text);
+        sdf_text(ref<const font> f, std::string_view text, const style& st, std::size_t max_cached = 8);
+
+        // Draw the text at a position, scaled relative to its font's size.
+        bool render(lref<renderer> rnd, coord::point pos, float scale);
+
+        // Resolve the text at a scale into a surface, without caching it.
+        [[nodiscard]] surface resolve(float scale) const;
+
+        // Get the size of the text (including effects) at a scale.
+        pixel::point size(float scale) const;
+
+        bool valid() const;
+
+    private:
+        // A resolved scale (in 1/64ths), in the top-left corner of a texture that may be bigger.
+        struct cache_slot
+        {
+            int               key;
+            pixel::point      size;
+            streaming_texture tex;
+        };
+
+        // Resolve the text into RGBA32 pixels of `size(scale)`.
+        void resolve(float scale, std::byte* pixels, int pitch) const;
+
+        // Get the distance to the outline at a point of the field.
+        float distance(coord::point pos) const;
+
+        // The field's alpha channel, which is all that's needed.
+        std::vector<std::uint8_t> m_field;
+        pixel::point              m_size { 0, 0 };
+
+        style       m_style;
+        std::size_t m_maxCached { 0 };
+
+        // Resolved scales, most recently used first.
+        std::vector<cache_slot> m_cache;
+
+        // The renderer that cached textures belong to.
+        const SDL_Renderer* m_renderer { nullptr };
+    };
 }
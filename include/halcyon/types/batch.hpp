@@ -0,0 +1,49 @@
+#pragma once
+
+#include <halcyon/video/types.hpp>
+
+#include <span>
+
+// types/batch.hpp:
+// Vectorized operations on arrays of points and rectangles.
+
+namespace hal::batch
+{
+    // A 2D affine transformation, mapping (x, y) to
+    // (xx * x + yx * y + tx, xy * x + yy * y + ty).
+    struct matrix
+    {
+        coord_t xx { 1 }, xy { 0 };
+        coord_t yx { 0 }, yy { 1 };
+        coord_t tx { 0 }, ty { 0 };
+    };
+
+    // The instruction set used by the functions below, chosen at runtime.
+    enum class isa : std::uint8_t
+    {
+        scalar,
+        sse2,
+        avx
+    };
+
+    isa instruction_set();
+
+    // Offset every point or rectangle.
+    void translate(std::span<coord::point> pts, coord::point offset);
+    void translate(std::span<coord::rect> rects, coord::point offset);
+
+    // Multiply every point, or both the position and size of every rectangle.
+    void scale(std::span<coord::point> pts, coord::point factor);
+    void scale(std::span<coord::rect> rects, coord::point factor);
+
+    // Transform every point. Rectangles are replaced by the bounding box of their transformed corners.
+    void affine(std::span<coord::point> pts, const matrix& m);
+    void affine(std::span<coord::rect> rects, const matrix& m);
+
+    // Anchor every rectangle's position by its size, like `point::anchor()`.
+    void anchor(std::span<coord::rect> rects, hal::anchor a);
+
+    // Check every rectangle for intersection with an area, like `operator|`.
+    // `out` must be at least as big as `rects`. Returns the amount of intersecting rectangles.
+    std::size_t intersect(std::span<const coord::rect> rects, const coord::rect& area, std::span<bool> out);
+}
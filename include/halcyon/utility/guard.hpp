@@ -94,9 +94,15 @@ namespace hal
             hal::color     m_old;
         };
 
+        // Restores the render target that was set before it (which may be the window),
+        // so that guards can be nested. The previous target should outlive the guard;
+        // if it's destroyed first, the window is restored instead.
         class target
         {
         public:
+            // Only remember the current target, to restore it after switching elsewhere.
+            target(lref<renderer> obj);
+
             target(lref<renderer> obj, ref<target_texture> tx);
 
             ~target();
@@ -105,6 +111,7 @@ namespace hal
 
         private:
             lref<renderer> m_ref;
+            SDL_Texture*   m_old;
         };
 
         class presentation
@@ -0,0 +1,481 @@
+#pragma once
+
+#include <halcyon/types/rectangle.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+// utility/spatial_index.hpp:
+// Acceleration structures for finding rectangles in an area or under a point.
+
+namespace hal
+{
+    namespace detail
+    {
+        // Entry storage shared by spatial indices. Entries are addressed by handles,
+        // which stay valid until the entry is removed; removed handles get reused.
+        template <typename T, pixel_or_coord Pos_Type>
+        class spatial_storage
+        {
+        public:
+            using handle  = std::uint32_t;
+            using pos_t   = Pos_Type;
+            using point_t = point<pos_t>;
+            using rect_t  = rectangle<pos_t>;
+
+            T& operator[](handle h)
+            {
+                return *m_entries[h].value;
+            }
+
+            const T& operator[](handle h) const
+            {
+                return *m_entries[h].value;
+            }
+
+            // Get the area an entry occupies.
+            const rect_t& area(handle h) const
+            {
+                return m_entries[h].area;
+            }
+
+            // Whether a handle refers to an entry that hasn't been removed.
+            bool contains(handle h) const
+            {
+                return h < m_entries.size() && m_entries[h].value.has_value();
+            }
+
+            std::size_t size() const
+            {
+                return m_entries.size() - m_free.size();
+            }
+
+            bool empty() const
+            {
+                return size() == 0;
+            }
+
+        protected:
+            struct entry
+            {
+                rect_t           area;
+                std::optional<T> value;
+
+                // Index-specific data (i.e. the owning node).
+                std::uint32_t tag;
+            };
+
+            handle allocate(const rect_t& area, T&& value)
+            {
+                if (m_free.empty())
+                {
+                    m_entries.push_back({ area, std::move(value), 0 });
+                    return static_cast<handle>(m_entries.size() - 1);
+                }
+
+                const handle ret { m_free.back() };
+                m_free.pop_back();
+
+                m_entries[ret] = { area, std::move(value), 0 };
+
+                return ret;
+            }
+
+            void release(handle h)
+            {
+                m_entries[h].value.reset();
+                m_free.push_back(h);
+            }
+
+            void clear_storage()
+            {
+                m_entries.clear();
+                m_free.clear();
+            }
+
+            std::vector<entry>  m_entries;
+            std::vector<handle> m_free;
+        };
+    }
+
+    // A uniform grid of buckets. Best suited for many similarly-sized objects spread across
+    // a large or unbounded area, i.e. sprites in a world. Every entry is stored in each cell
+    // it overlaps, so objects much larger than a cell make for slow insertions.
+    template <typename T, detail::pixel_or_coord Pos_Type = coord_t>
+    class spatial_grid : public detail::spatial_storage<T, Pos_Type>
+    {
+        using base = detail::spatial_storage<T, Pos_Type>;
+
+    public:
+        using typename base::handle;
+        using typename base::point_t;
+        using typename base::pos_t;
+        using typename base::rect_t;
+
+        // Create a grid with square cells of a certain size (at least 1).
+        spatial_grid(pos_t cell_size)
+            : m_cellSize { std::max(cell_size, pos_t(1)) }
+        {
+        }
+
+        handle insert(const rect_t& area, T value)
+        {
+            const handle ret { base::allocate(area, std::move(value)) };
+
+            for_cells(area, [&](std::uint64_t k)
+                { m_cells[k].push_back(ret); });
+
+            return ret;
+        }
+
+        // Change the area of an entry.
+        void move(handle h, const rect_t& area)
+        {
+            if (cells_of(base::area(h)) != cells_of(area))
+            {
+                unlink(h);
+
+                for_cells(area, [&](std::uint64_t k)
+                    { m_cells[k].push_back(h); });
+            }
+
+            base::m_entries[h].area = area;
+        }
+
+        void remove(handle h)
+        {
+            unlink(h);
+            base::release(h);
+        }
+
+        void clear()
+        {
+            m_cells.clear();
+            base::clear_storage();
+        }
+
+        // Call a function with the handle of every entry intersecting an area.
+        // Entries are reported once, in no particular order. Queries don't modify
+        // the grid, so several of them can run at once.
+        template <std::invocable<handle> F>
+        void query(const rect_t& area, F&& func) const
+        {
+            const cell_range qr { cells_of(area) };
+
+            for (std::int64_t y { qr.y0 }; y <= qr.y1; ++y)
+                for (std::int64_t x { qr.x0 }; x <= qr.x1; ++x)
+                {
+                    const auto iter = m_cells.find(key(x, y));
+
+                    if (iter == m_cells.end())
+                        continue;
+
+                    for (handle h : iter->second)
+                    {
+                        const rect_t&    ea { base::area(h) };
+                        const cell_range er { cells_of(ea) };
+
+                        // Entries spanning multiple cells are only reported from the
+                        // first cell they share with the queried area.
+                        if (x == std::max(er.x0, qr.x0) && y == std::max(er.y0, qr.y0) && (ea | area))
+                            func(h);
+                    }
+                }
+        }
+
+        // Call a function with the handle of every entry under a point.
+        template <std::invocable<handle> F>
+        void query(const point_t& pt, F&& func) const
+        {
+            const auto iter = m_cells.find(key(cell_of(pt.x), cell_of(pt.y)));
+
+            if (iter == m_cells.end())
+                return;
+
+            for (handle h : iter->second)
+            {
+                if (pt | base::area(h))
+                    func(h);
+            }
+        }
+
+        pos_t cell_size() const
+        {
+            return m_cellSize;
+        }
+
+    private:
+        struct cell_range
+        {
+            std::int64_t x0, y0, x1, y1;
+
+            bool operator==(const cell_range&) const = default;
+        };
+
+        std::int64_t cell_of(pos_t val) const
+        {
+            return static_cast<std::int64_t>(std::floor(static_cast<double>(val) / static_cast<double>(m_cellSize)));
+        }
+
+        // Edges are inclusive, matching `operator|` for rectangles.
+        cell_range cells_of(const rect_t& area) const
+        {
+            return { cell_of(area.pos.x), cell_of(area.pos.y), cell_of(area.pos.x + area.size.x), cell_of(area.pos.y + area.size.y) };
+        }
+
+        static std::uint64_t key(std::int64_t x, std::int64_t y)
+        {
+            return static_cast<std::uint64_t>(static_cast<std::uint32_t>(x)) << 32 | static_cast<std::uint32_t>(y);
+        }
+
+        template <typename F>
+        void for_cells(const rect_t& area, F&& func) const
+        {
+            const cell_range cr { cells_of(area) };
+
+            for (std::int64_t y { cr.y0 }; y <= cr.y1; ++y)
+                for (std::int64_t x { cr.x0 }; x <= cr.x1; ++x)
+                    func(key(x, y));
+        }
+
+        void unlink(handle h)
+        {
+            for_cells(base::area(h), [&](std::uint64_t k)
+                {
+                    std::vector<handle>& cell { m_cells[k] };
+
+                    std::erase(cell, h);
+
+                    if (cell.empty())
+                        m_cells.erase(k); });
+        }
+
+        std::unordered_map<std::uint64_t, std::vector<handle>> m_cells;
+
+        pos_t m_cellSize;
+    };
+
+    // A region quadtree. Best suited for objects of widely varying sizes within a known area,
+    // i.e. UI elements. Every entry is stored in the smallest node that fully contains it;
+    // entries that lie (partially) outside of the tree's bounds are stored in the root.
+    template <typename T, detail::pixel_or_coord Pos_Type = coord_t>
+    class quadtree : public detail::spatial_storage<T, Pos_Type>
+    {
+        using base = detail::spatial_storage<T, Pos_Type>;
+
+    public:
+        using typename base::handle;
+        using typename base::point_t;
+        using typename base::pos_t;
+        using typename base::rect_t;
+
+        // Create a quadtree covering an area. Nodes get split once they have
+        // more than `node_capacity` entries, unless `max_depth` has been reached.
+        quadtree(const rect_t& bounds, std::size_t node_capacity = 8, std::size_t max_depth = 8)
+            : m_capacity { std::max<std::size_t>(node_capacity, 1) }
+            , m_maxDepth { max_depth }
+        {
+            m_nodes.push_back({ bounds, no_children, 0, {} });
+        }
+
+        handle insert(const rect_t& area, T value)
+        {
+            const handle ret { base::allocate(area, std::move(value)) };
+            place(ret);
+
+            return ret;
+        }
+
+        // Change the area of an entry.
+        void move(handle h, const rect_t& area)
+        {
+            const node& n { m_nodes[base::m_entries[h].tag] };
+
+            // Still in the same leaf; nothing to rearrange.
+            if (n.children == no_children && encloses(n.bounds, area))
+            {
+                base::m_entries[h].area = area;
+                return;
+            }
+
+            unlink(h);
+            base::m_entries[h].area = area;
+            place(h);
+        }
+
+        void remove(handle h)
+        {
+            unlink(h);
+            base::release(h);
+        }
+
+        // Remove all entries and collapse the tree.
+        void clear()
+        {
+            m_nodes.resize(1);
+
+            m_nodes.front().children = no_children;
+            m_nodes.front().items.clear();
+
+            base::clear_storage();
+        }
+
+        // Call a function with the handle of every entry intersecting an area.
+        template <std::invocable<handle> F>
+        void query(const rect_t& area, F&& func) const
+        {
+            visit([&](const rect_t& bounds)
+                { return bounds | area; },
+                [&](handle h)
+                {
+                    if (base::area(h) | area)
+                        func(h);
+                });
+        }
+
+        // Call a function with the handle of every entry under a point.
+        template <std::invocable<handle> F>
+        void query(const point_t& pt, F&& func) const
+        {
+            visit([&](const rect_t& bounds)
+                { return pt | bounds; },
+                [&](handle h)
+                {
+                    if (pt | base::area(h))
+                        func(h);
+                });
+        }
+
+        const rect_t& bounds() const
+        {
+            return m_nodes.front().bounds;
+        }
+
+    private:
+        constexpr static std::uint32_t no_children { 0 };
+
+        struct node
+        {
+            rect_t bounds;
+
+            // Index of the first of four consecutive children.
+            std::uint32_t children;
+            std::uint32_t depth;
+
+            std::vector<handle> items;
+        };
+
+        static bool encloses(const rect_t& outer, const rect_t& inner)
+        {
+            return inner.pos.x >= outer.pos.x && inner.pos.y >= outer.pos.y && inner.pos.x + inner.size.x <= outer.pos.x + outer.size.x && inner.pos.y + inner.size.y <= outer.pos.y + outer.size.y;
+        }
+
+        // Find the child of a node that fully contains an area, if any.
+        std::uint32_t child_for(const node& n, const rect_t& area) const
+        {
+            for (std::uint32_t i { n.children }; i < n.children + 4; ++i)
+            {
+                if (encloses(m_nodes[i].bounds, area))
+                    return i;
+            }
+
+            return no_children;
+        }
+
+        void place(handle h)
+        {
+            const rect_t& area { base::area(h) };
+
+            std::uint32_t idx { 0 };
+
+            if (encloses(m_nodes.front().bounds, area))
+            {
+                for (std::uint32_t c; m_nodes[idx].children != no_children && (c = child_for(m_nodes[idx], area)) != no_children;)
+                    idx = c;
+            }
+
+            m_nodes[idx].items.push_back(h);
+            base::m_entries[h].tag = idx;
+
+            if (m_nodes[idx].children == no_children && m_nodes[idx].items.size() > m_capacity && m_nodes[idx].depth < m_maxDepth)
+                split(idx);
+        }
+
+        void split(std::uint32_t idx)
+        {
+            const rect_t        b { m_nodes[idx].bounds };
+            const std::uint32_t depth { m_nodes[idx].depth + 1 };
+
+            // Integer sizes might not divide evenly.
+            const point_t half { b.size.x / 2, b.size.y / 2 };
+            const point_t rest { b.size - half };
+
+            const auto first = static_cast<std::uint32_t>(m_nodes.size());
+
+            m_nodes.push_back({ { b.pos, half }, no_children, depth, {} });
+            m_nodes.push_back({ { { b.pos.x + half.x, b.pos.y }, { rest.x, half.y } }, no_children, depth, {} });
+            m_nodes.push_back({ { { b.pos.x, b.pos.y + half.y }, { half.x, rest.y } }, no_children, depth, {} });
+            m_nodes.push_back({ { b.pos + half, rest }, no_children, depth, {} });
+
+            // The push_backs above might have invalidated references.
+            node& n { m_nodes[idx] };
+            n.children = first;
+
+            std::vector<handle> items { std::move(n.items) };
+            n.items.clear();
+
+            for (handle h : items)
+            {
+                const std::uint32_t c { child_for(n, base::area(h)) };
+                const std::uint32_t target { c == no_children ? idx : c };
+
+                m_nodes[target].items.push_back(h);
+                base::m_entries[h].tag = target;
+            }
+        }
+
+        void unlink(handle h)
+        {
+            std::vector<handle>& items { m_nodes[base::m_entries[h].tag].items };
+
+            // Order within a node doesn't matter.
+            const auto iter = std::ranges::find(items, h);
+            *iter           = items.back();
+            items.pop_back();
+        }
+
+        // Depth-first traversal; the root's entries are always checked,
+        // since it holds anything that's out of bounds.
+        template <typename Pred, typename F>
+        void visit(Pred&& enter, F&& func) const
+        {
+            std::vector<std::uint32_t> stack { 0 };
+
+            while (!stack.empty())
+            {
+                const node& n { m_nodes[stack.back()] };
+                stack.pop_back();
+
+                for (handle h : n.items)
+                    func(h);
+
+                if (n.children != no_children)
+                {
+                    for (std::uint32_t i { n.children }; i < n.children + 4; ++i)
+                    {
+                        if (enter(m_nodes[i].bounds))
+                            stack.push_back(i);
+                    }
+                }
+            }
+        }
+
+        std::vector<node> m_nodes;
+
+        std::size_t m_capacity, m_maxDepth;
+    };
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <latch>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// utility/thread_pool.hpp:
+// A fixed amount of worker threads, for offloading CPU-bound work.
+
+namespace hal
+{
+    // A simple FIFO thread pool. Tasks are run in the order they were pushed,
+    // though they can obviously finish in any order.
+    // Remember that most of SDL (rendering in particular) must only be used on the main thread.
+    class thread_pool
+    {
+    public:
+        using task = std::move_only_function<void()>;
+
+        // Create a pool with a worker for every logical core except the calling one.
+        thread_pool();
+
+        // Create a pool with a specific amount of workers (at least one).
+        thread_pool(std::size_t workers);
+
+        thread_pool(const thread_pool&) = delete;
+        thread_pool(thread_pool&&)      = delete;
+
+        // Finishes all queued tasks, then joins the workers.
+        ~thread_pool();
+
+        // Queue a task. Tasks must not throw, since that terminates the
+        // program; use submit() to get exceptions through a future instead.
+        void push(task t);
+
+        // Queue a task and get a future of its result.
+        template <std::invocable F>
+        [[nodiscard]] auto submit(F&& func)
+        {
+            std::packaged_task<std::invoke_result_t<F>()> pt { std::forward<F>(func) };
+
+            auto ret = pt.get_future();
+            push(std::move(pt));
+
+            return ret;
+        }
+
+        // Call a function for every index in [0, n) and wait for all of them to finish.
+        // The calling thread takes part in the work as well. If the function throws,
+        // remaining indices are skipped and the first exception is rethrown once every
+        // thread has stopped using it.
+        // Do not call this from within a task running on the same pool.
+        template <std::invocable<std::size_t> F>
+        void for_each(std::size_t n, F&& func)
+        {
+            std::atomic<std::size_t> next { 0 };
+
+            std::exception_ptr error;
+            std::mutex         error_mutex;
+
+            const auto work = [&]
+            {
+                try
+                {
+                    for (std::size_t i { next++ }; i < n; i = next++)
+                        func(i);
+                }
+
+                catch (...)
+                {
+                    next = n;
+
+                    std::lock_guard _ { error_mutex };
+
+                    if (!error)
+                        error = std::current_exception();
+                }
+            };
+
+            const std::size_t helpers { std::min(n, size()) };
+
+            std::latch done { static_cast<std::ptrdiff_t>(helpers) };
+
+            for (std::size_t i { 0 }; i < helpers; ++i)
+                push([&]
+                    { work(); done.count_down(); });
+
+            work();
+            done.wait();
+
+            if (error)
+                std::rethrow_exception(error);
+        }
+
+        // Wait until all queued tasks have finished.
+        void wait();
+
+        // Get the amount of workers.
+        std::size_t size() const;
+
+    private:
+        void run(std::stop_token st);
+
+        std::deque<task> m_tasks;
+
+        std::mutex              m_mutex;
+        std::condition_variable m_taskAdded, m_taskDone;
+
+        std::size_t m_active;
+
+        // Declared last, so that workers are joined before anything else is destroyed.
+        std::vector<std::jthread> m_workers;
+    };
+}
@@ -2,11 +2,20 @@
 
 #include <halcyon/events.hpp>
 
+#include <halcyon/video/cached_layer.hpp>
+#include <halcyon/video/capture_queue.hpp>
+#include <halcyon/video/command_buffer.hpp>
+#include <halcyon/video/dirty_region.hpp>
 #include <halcyon/video/display.hpp>
 #include <halcyon/video/driver.hpp>
+#include <halcyon/video/frame_recorder.hpp>
 #include <halcyon/video/message_box.hpp>
+#include <halcyon/video/mip_texture.hpp>
 #include <halcyon/video/renderer.hpp>
+#include <halcyon/video/sprite_batch.hpp>
 #include <halcyon/video/texture.hpp>
+#include <halcyon/video/tiled_texture.hpp>
+#include <halcyon/video/tilemap.hpp>
 #include <halcyon/video/window.hpp>
 
 #include <halcyon/types/string.hpp>
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <halcyon/utility/guard.hpp>
+#include <halcyon/video/renderer.hpp>
+
+// video/cached_layer.hpp:
+// Render-to-texture caching of rarely changing content.
+
+namespace hal
+{
+    // A target texture that holds the result of an expensive series of draws (i.e. a menu),
+    // which is only redrawn when invalidated, and otherwise drawn as a single texture.
+    // Layers can be nested; the previous render target is restored after updating.
+    // Some renderers lose the contents of target textures (SDL_EVENT_RENDER_TARGETS_RESET);
+    // invalidate all layers when that happens.
+    class cached_layer
+    {
+    public:
+        // Create a transparent layer of a certain size.
+        cached_layer(lref<renderer> rnd, pixel::point size);
+
+        // Redraw the layer's contents if it's been invalidated. The function gets called
+        // with the renderer targeting the layer, which is cleared to transparent beforehand.
+        // Returns false if the render target could not be changed.
+        template <std::invocable<renderer&> F>
+        bool update(F&& func)
+        {
+            if (!m_dirty)
+                return true;
+
+            guard::target _ { m_renderer };
+
+            if (!begin())
+                return false;
+
+            func(m_renderer());
+
+            m_dirty = false;
+
+            return true;
+        }
+
+        // Update the layer if needed and draw it at a position.
+        template <std::invocable<renderer&> F>
+        bool render(coord::point pos, F&& func)
+        {
+            return update(std::forward<F>(func)) && draw().to(pos).render();
+        }
+
+        // Mark the contents as outdated; they will be redrawn upon the next update.
+        void invalidate();
+
+        // Whether the contents need to be redrawn.
+        bool dirty() const;
+
+        // Change the size of the layer. This recreates the texture and invalidates it.
+        bool resize(pixel::point size);
+
+        // Draw the cached texture. Returns a builder-like class.
+        // Does not update the layer. Since translucent draws leave the layer with
+        // premultiplied colors, its texture uses `blend_mode::alpha_premul`.
+        [[nodiscard]] copyer draw();
+
+        const target_texture& texture() const;
+
+    private:
+        // Target the layer and clear it.
+        bool begin();
+
+        lref<renderer> m_renderer;
+        target_texture m_texture;
+
+        bool m_dirty;
+    };
+}
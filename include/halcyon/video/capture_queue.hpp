@@ -0,0 +1,93 @@
+#pragma once
+
+#include <halcyon/surface.hpp>
+#include <halcyon/video/renderer.hpp>
+
+#include <deque>
+#include <functional>
+#include <vector>
+
+// video/capture_queue.hpp:
+// Reading back render targets without stalling the frame that captured them.
+
+namespace hal
+{
+    class outputter;
+    class thread_pool;
+
+    // Captures render targets by copying them into staging textures on the GPU, and only
+    // reads those back a few frames later, right after presenting, when there's nothing
+    // left queued for the GPU to finish. Handlers (i.e. image encoding) can run on a pool.
+    // Captures of the window itself (no texture target) cannot be staged and are read
+    // immediately; render into a texture first to capture asynchronously.
+    class capture_queue
+    {
+    public:
+        using ticket = std::uint64_t;
+
+        // Gets the captured pixels. Runs in `update()`, or on a worker if a pool is used.
+        using handler = std::move_only_function<void(surface)>;
+
+        // Read back captures `delay` frames (calls to `update()`) after they were made.
+        capture_queue(lref<renderer> rnd, std::size_t delay = 2);
+
+        // Also run handlers on a thread pool, which must outlive this object.
+        capture_queue(lref<renderer> rnd, thread_pool& pool, std::size_t delay = 2);
+
+        // Capture the current render target; get the result via `take()`.
+        ticket capture();
+
+        // Capture the current render target and hand the result over to a function.
+        ticket capture(handler h);
+
+        // Capture a texture; get the result via `take()`.
+        ticket capture(ref<texture> src);
+
+        // Capture a texture and hand the result over to a function.
+        ticket capture(ref<texture> src, handler h);
+
+        // Read back captures that are old enough. Call once per frame, after presenting.
+        // Returns the amount of captures read back.
+        std::size_t update();
+
+        // Read back all pending captures right away.
+        std::size_t flush();
+
+        // Get the result of a capture made without a handler, if it has been read back.
+        // Returns an invalid surface otherwise. Each result can only be taken once.
+        surface take(ticket t);
+
+        // Get the amount of captures that haven't been read back yet.
+        std::size_t pending() const;
+
+        // A handler that encodes captures as PNG images.
+        static handler png(outputter dst);
+
+    private:
+        struct capture_data
+        {
+            ticket         id;
+            std::uint64_t  frame;
+            target_texture staging;
+            handler        func;
+        };
+
+        ticket stage(ref<texture> src, handler h);
+
+        // Hand over a read back surface to its handler, or keep it for `take()`.
+        void deliver(ticket id, surface s, handler h);
+
+        std::size_t read_back(std::size_t max_age);
+
+        lref<renderer> m_renderer;
+        thread_pool*   m_pool;
+
+        std::deque<capture_data>                m_pending;
+        std::vector<target_texture>             m_staging;
+        std::vector<std::pair<ticket, surface>> m_done;
+
+        std::size_t   m_delay;
+        std::uint64_t m_frame;
+        ticket        m_next;
+    };
+}
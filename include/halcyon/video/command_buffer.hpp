@@ -0,0 +1,185 @@
+#pragma once
+
+#include <halcyon/video/renderer.hpp>
+
+#include <halcyon/utility/thread_pool.hpp>
+
+#include <vector>
+
+// video/command_buffer.hpp:
+// Retained-mode rendering; commands are recorded, sorted by state and submitted later.
+
+namespace hal
+{
+    class command_buffer;
+
+    // A builder-pattern class that records a texture copy into a command buffer.
+    // Its interface mirrors that of `hal::copyer`.
+    class recorder : public detail::drawer<const texture, renderer, coord_t, recorder>
+    {
+    public:
+        [[nodiscard]] recorder(ref<const texture> tx, ref<renderer> rnd, command_buffer& buf);
+
+        // Finish the operation.
+        void render();
+        void rotated(double angle, flip f);
+
+    private:
+        command_buffer* m_buffer;
+    };
+
+    // A list of draw, fill and copy operations that can be submitted to a renderer at once.
+    // Before submission, commands are sorted by (layer, target, texture, blend mode, color),
+    // and subsequent commands that share the same state are merged into a single SDL call.
+    // Commands within a layer can be freely reordered, so if drawing order matters
+    // (i.e. a texture is drawn over a filled area), put them in separate layers.
+    // Submitting does not clear the buffer, so it can be recorded once and submitted many times.
+    class command_buffer
+    {
+    public:
+        using layer_t = std::uint32_t;
+
+        // A single recorded operation.
+        struct command
+        {
+            enum class kind : std::uint8_t
+            {
+                point,
+                line,
+                outline,
+                fill,
+                copy,
+                copy_rotated
+            };
+
+            // Sorting key.
+            layer_t      layer;
+            SDL_Texture* target;
+            SDL_Texture* texture;
+            blend_mode   blend;
+            hal::color   color;
+
+            kind type;
+            flip flip_mode;
+
+            double angle;
+
+            // For points, only `dst.pos` is used.
+            // For lines, `dst.pos` is the start and `dst.size` the end.
+            // For copies, both rectangles are used as-is.
+            coord::rect src, dst;
+        };
+
+        command_buffer(lref<renderer> rnd);
+
+        // Set the layer of subsequently recorded commands.
+        // Layers are submitted in ascending order.
+        void    layer(layer_t l);
+        layer_t layer() const;
+
+        // Set the draw color of subsequently recorded commands.
+        void       color(hal::color c);
+        hal::color color() const;
+
+        // Set the blend mode of subsequently recorded commands.
+        void       blend(blend_mode bm);
+        blend_mode blend() const;
+
+        // Set the render target of subsequently recorded commands.
+        void target(ref<target_texture> tx);
+        void reset_target();
+
+        // Discard subsequently recorded commands that lie entirely outside of an area,
+        // i.e. `renderer::visible_area()`. Discarded commands are never stored.
+        void cull(coord::rect area);
+        void reset_cull();
+
+        // Record drawing a point (pixel).
+        void draw(coord::point pt);
+        void draw(coord::point pt, hal::color c);
+
+        void draw(std::span<const coord::point> pts);
+        void draw(std::span<const coord::point> pts, hal::color c);
+
+        // Record drawing a line.
+        void draw(coord::point from, coord::point to);
+        void draw(coord::point from, coord::point to, hal::color c);
+
+        // Record outlining a rectangle.
+        void draw(coord::rect area);
+        void draw(coord::rect area, hal::color c);
+
+        void draw(std::span<const coord::rect> areas);
+        void draw(std::span<const coord::rect> areas, hal::color c);
+
+        // Record drawing a texture. Returns a builder-like class.
+        [[nodiscard]] recorder draw(ref<const texture> tx);
+
+        // Record filling an area.
+        void fill(coord::rect area);
+        void fill(coord::rect area, hal::color c);
+
+        void fill(std::span<const coord::rect> areas);
+        void fill(std::span<const coord::rect> areas, hal::color c);
+
+        // Sort commands by state. Done automatically by `command_buffer::submit()`,
+        // but can be called in advance, i.e. on another thread.
+        void sort();
+
+        // Add another buffer's commands to this one. Commands that compare equal
+        // keep their relative order, with this buffer's commands coming first.
+        // If both buffers are sorted, this is a linear merge instead of a full sort.
+        void merge(const command_buffer& other);
+
+        // Execute all recorded commands on the renderer.
+        // The renderer's draw color, blend mode and target are restored afterwards.
+        bool submit();
+
+        // Remove all recorded commands. Keeps the current state.
+        void clear();
+
+        std::span<const command> commands() const;
+
+        std::size_t size() const;
+        bool        empty() const;
+
+    private:
+        friend class recorder;
+
+        // Create a command with the current state.
+        command make(command::kind k, coord::rect dst) const;
+
+        void push(const command& cmd);
+
+        std::vector<command> m_commands;
+
+        // Scratch space for merging commands during submission.
+        std::vector<coord::point> m_scratchPoints;
+        std::vector<coord::rect>  m_scratchRects;
+
+        lref<renderer> m_renderer;
+
+        SDL_Texture* m_target;
+        coord::rect  m_cullArea;
+        layer_t      m_layer;
+        hal::color   m_color;
+        blend_mode   m_blend;
+
+        bool m_sorted, m_cull;
+    };
+
+    // Record into multiple command buffers in parallel. `func` gets called on the pool's
+    // workers (and the calling thread) with every buffer and its index, after which each
+    // buffer is sorted on the same thread. Merge the results into a single buffer and submit
+    // it from the rendering thread afterwards.
+    // Recording doesn't call into SDL; a `hal::recorder` only reads its texture's size
+    // straight from the SDL_Texture. Don't destroy textures while recording is in progress.
+    template <std::invocable<command_buffer&, std::size_t> F>
+    void record_parallel(thread_pool& pool, std::span<command_buffer> buffers, F&& func)
+    {
+        pool.for_each(buffers.size(), [&](std::size_t i)
+            {
+                func(buffers[i], i);
+                buffers[i].sort(); });
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <halcyon/video/types.hpp>
+
+#include <span>
+#include <vector>
+
+// video/dirty_region.hpp:
+// Tracking of changed areas, so that textures can be partially updated.
+
+namespace hal
+{
+    // A list of rectangles that have changed since the last upload.
+    // Rectangles are merged as they are added, which keeps the amount
+    // of (comparatively expensive) texture updates low.
+    class dirty_region
+    {
+    public:
+        // Heuristics that decide when two areas get merged into their bounding box.
+        struct merge_policy
+        {
+            // The maximum amount of tracked rectangles. Once exceeded, the pair
+            // whose merge wastes the least area is forcefully merged.
+            std::size_t max_rects { 16 };
+
+            // Two rectangles are merged if the part of their bounding box that
+            // neither of them covers is at most this fraction of the box's area.
+            float max_waste { 0.25f };
+        };
+
+        // Track changes without clipping them to any area.
+        dirty_region() = default;
+
+        // Track changes within an area of a certain size, i.e. that of a surface.
+        // Added rectangles are clipped to it.
+        dirty_region(pixel::point bounds);
+        dirty_region(pixel::point bounds, merge_policy mp);
+
+        // Mark an area as changed.
+        void add(pixel::rect area);
+
+        // Mark the entire tracked area as changed.
+        void add_all();
+
+        // Forget about all changes, i.e. after uploading them.
+        void clear();
+
+        bool empty() const;
+
+        // Get the (non-overlapping or merged) changed areas.
+        std::span<const pixel::rect> rects() const;
+
+        // Get the bounding box of all changed areas.
+        pixel::rect extent() const;
+
+        // Get the total changed area, in pixels.
+        std::int64_t area() const;
+
+        pixel::point bounds() const;
+
+        const merge_policy& policy() const;
+        void                policy(merge_policy mp);
+
+    private:
+        void enforce_limit();
+
+        std::vector<pixel::rect> m_rects;
+
+        pixel::point m_bounds;
+        merge_policy m_policy;
+    };
+}
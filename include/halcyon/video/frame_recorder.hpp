@@ -0,0 +1,100 @@
+#pragma once
+
+#include <halcyon/surface.hpp>
+#include <halcyon/video/capture_queue.hpp>
+#include <halcyon/video/renderer.hpp>
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <vector>
+
+// video/frame_recorder.hpp:
+// Recording rendered frames into a stream, encoded on worker threads.
+
+namespace hal
+{
+    class thread_pool;
+
+    // Captures frames through a capture queue and encodes them on a thread pool, writing
+    // them to the output in order. Frames wait for their encoding in a fixed amount of
+    // reusable surfaces; when all of them are taken, recording blocks instead of dropping frames.
+    // Like the queue, only texture targets are read back without stalling the render thread.
+    class frame_recorder
+    {
+    public:
+        enum class format : std::uint8_t
+        {
+            rgba,   // Raw RGBA32 frames, back to back.
+            yuv420, // Raw planar YUV 4:2:0 (I420) frames, BT.601 limited range, back to back.
+            qoi     // Complete QOI images, back to back.
+        };
+
+        // Record into an output. All frames have the size of the first one;
+        // others (i.e. after resizing the window) are scaled to fit.
+        // The pool must outlive the recorder.
+        frame_recorder(lref<renderer> rnd, outputter dst, thread_pool& pool, format fmt = format::qoi, std::size_t max_queued = 4);
+
+        frame_recorder(const frame_recorder&) = delete;
+        frame_recorder(frame_recorder&&)      = delete;
+
+        // Waits for all recorded frames to be written.
+        ~frame_recorder();
+
+        // Capture the current render target; it's read back and encoded in a later `update()`.
+        // Call right before presenting, since the window's contents are undefined afterwards.
+        // Returns false if any previous frame failed to be recorded.
+        bool record();
+
+        // Hand over captures that have been read back to the encoder.
+        // Call once per frame, after presenting.
+        void update();
+
+        // Read back all remaining captures and wait until all recorded frames have been
+        // written. Returns false if any frame failed to be captured, encoded or written.
+        bool finish();
+
+        // Get the amount of frames written so far.
+        std::size_t frames() const;
+
+        // Get the size of recorded frames, which is known after the first one.
+        pixel::point size() const;
+
+    private:
+        // Copy a read back capture into a free surface and queue it for encoding.
+        void submit(std::size_t index, surface read);
+
+        // Get a free surface, waiting for one if needed.
+        surface acquire();
+
+        // Encode a frame on a worker and write it once all previous ones have been.
+        void encode(std::size_t index, surface frame);
+
+        // Write encoded frames that are next in line. Expects the mutex to be locked.
+        void write(std::size_t index, std::vector<std::uint8_t> data);
+
+        lref<renderer> m_renderer;
+        outputter      m_output;
+        thread_pool&   m_pool;
+        capture_queue  m_captures;
+
+        const format      m_format;
+        const std::size_t m_maxQueued;
+
+        pixel::point m_size;
+
+        // Protects everything below it.
+        mutable std::mutex      m_mutex;
+        std::condition_variable m_changed;
+
+        std::vector<surface> m_free;
+        std::size_t          m_allocated;
+
+        // Encoded frames waiting for previous ones to be written.
+        std::map<std::size_t, std::vector<std::uint8_t>> m_encoded;
+
+        std::size_t m_recorded, m_written;
+
+        bool m_failed;
+    };
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <halcyon/video/texture.hpp>
+
+#include <span>
+#include <vector>
+
+// video/mip_texture.hpp:
+// Textures with pre-filtered, downscaled versions of themselves.
+
+namespace hal
+{
+    // A texture and its mipmap chain, every level half the size of the previous one.
+    // Drawing it via `renderer::draw()` picks the smallest level that is still at least as
+    // big as the destination, so heavily downscaled textures neither alias nor waste bandwidth.
+    class mip_texture
+    {
+    public:
+        mip_texture() = default;
+
+        // Upload a surface and its mip chain, built via `surface::build_mips()`.
+        mip_texture(lref<const renderer> rnd, const surface& surf, resample_filter rf = resample_filter::box, bool gamma_correct = false);
+
+        // Upload prepared levels, the first of which is the full-size image.
+        mip_texture(lref<const renderer> rnd, std::span<const surface> levels);
+
+        // Get the level to draw with when scaling the full-size image by a factor.
+        std::size_t level_for(float scale) const;
+
+        const static_texture& level(std::size_t index) const;
+        std::size_t           levels() const;
+
+        // Get the size of the full-size level.
+        pixel::point size() const;
+
+        // Set modifiers of every level.
+        bool alpha_mod(color::value_t val);
+        bool color_mod(color mod);
+        bool blend(blend_mode bm);
+
+        // Whether all levels have been uploaded successfully.
+        bool valid() const;
+
+    private:
+        std::vector<static_texture> m_levels;
+    };
+}
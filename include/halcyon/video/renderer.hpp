@@ -7,6 +7,7 @@
 
 #include <halcyon/utility/buffer.hpp>
 #include <halcyon/utility/enum_bits.hpp>
+#include <halcyon/utility/timer.hpp>
 
 #include <halcyon/properties.hpp>
 
@@ -15,16 +16,44 @@
 
 namespace hal
 {
+    namespace compile_settings
+    {
+        // `true` if `HAL_RENDERER_STATS` is defined (CMake option `HALCYON_RENDERER_STATS`).
+        constexpr bool renderer_stats {
+#ifdef HAL_RENDERER_STATS
+            true
+#else
+            false
+#endif
+        };
+    }
+
     // Forward declarations for parameters and return types.
     class surface;
     class window;
     class copyer;
+    class mip_texture;
     class renderer;
     class texture;
 
     class static_texture;
     class target_texture;
 
+    // A single vertex of `renderer::draw_geometry()`. Layout-compatible with SDL_Vertex.
+    struct vertex
+    {
+        coord::point pos;
+        SDL_FColor   color;
+
+        // Normalized texture coordinates.
+        coord::point tex;
+
+        constexpr static SDL_FColor to_fcolor(hal::color c)
+        {
+            return { c.r / 255.0f, c.g / 255.0f, c.b / 255.0f, c.a / 255.0f };
+        }
+    };
+
     enum class flip : std::uint8_t
     {
         none = SDL_FLIP_NONE,
@@ -70,6 +99,30 @@ namespace hal
             const pixel::format* formats() const;
         };
 
+        // Counters of work submitted to a renderer since the last reset.
+        // Only gathered if `compile_settings::renderer_stats` is true; otherwise, all zero.
+        struct statistics
+        {
+            // SDL render calls; merged calls (i.e. drawing a span of rectangles) count once.
+            std::uint64_t draw_calls;
+
+            // Points, lines, rectangles and texture copies.
+            std::uint64_t primitives;
+
+            // Texture copies using a different texture than the previous copy.
+            std::uint64_t texture_binds;
+
+            std::uint64_t target_switches;
+
+            // Bytes passed to texture creation, updates and locks.
+            std::uint64_t bytes_uploaded;
+
+            std::uint64_t presents;
+
+            // Time spent inside `renderer::present()`.
+            timer::clock::duration present_time;
+        };
+
         renderer() = default;
 
         // Create a renderer for a window.
@@ -127,6 +180,10 @@ namespace hal
         // Draw a texture. Returns a builder-like class.
         [[nodiscard]] copyer draw(ref<const texture> tx);
 
+        // Draw a mipmapped texture. The level is chosen when finishing the operation,
+        // based on the final destination size. The texture must outlive the copyer.
+        [[nodiscard]] copyer draw(const mip_texture& mips);
+
         // Fill an area.
         bool fill(coord::rect area);
         bool fill(coord::rect area, color c);
@@ -139,6 +196,10 @@ namespace hal
         bool fill();
         bool fill(color c);
 
+        // Draw triangles, optionally textured (pass an invalid reference otherwise).
+        // If `indices` is empty, every three vertices make up a triangle.
+        bool draw_geometry(ref<const texture> tx, std::span<const vertex> vertices, std::span<const int> indices);
+
         // Get/set the rendering target.
         bool target(ref<target_texture> tx);
         bool reset_target();
@@ -157,6 +218,16 @@ namespace hal
         result<blend_mode> blend() const;
         bool               blend(blend_mode bm);
 
+        // Get/set the drawing area of the current target.
+        // Drawing coordinates are relative to the viewport's position.
+        result<pixel::rect> viewport() const;
+        bool                viewport(pixel::rect area);
+        bool                reset_viewport();
+
+        // Get the area that's visible in drawing coordinates, which is the viewport's size.
+        // Use this with `copyer::cull()` to skip drawing anything off-screen.
+        result<coord::rect> visible_area() const;
+
         // There's only a getter here; to set the output size, use
         // `renderer::presentation()`.
         result<pixel::point> size() const;
@@ -198,6 +269,11 @@ namespace hal
 
         properties props() const;
 
+        // Get the statistics gathered since the last reset.
+        // Typically read and reset once per frame, right after presenting.
+        statistics stats() const;
+        void       reset_stats();
+
     private:
         // Helper for setting the render target.
         bool internal_target(SDL_Texture* target);
@@ -211,6 +287,16 @@ namespace hal
     public:
         using drawer::drawer;
 
+        // Draw from a mipmapped texture; see `renderer::draw(const mip_texture&)`.
+        copyer(const mip_texture& mips, ref<renderer> dst);
+
+        using drawer::cull;
+
+        // Skip the operation if the destination lies outside of the renderer's visible area.
+        // This queries the renderer on every call; when drawing many textures, prefer
+        // getting `renderer::visible_area()` once and passing it to `cull(area)`.
+        [[nodiscard]] copyer& cull();
+
         // Outlines the current destination with the renderer's draw color.
         // Can be called at any time, but you probably want to call this
         // after properly setting the destination rectangle.
@@ -229,5 +315,12 @@ namespace hal
         bool affine(coord::point right, coord::point down);
         bool tiled(float scale);
         bool nine_grid(float width_left, float width_right, float height_top, float height_bottom, float scale);
+
+    private:
+        // Switch to the mip level fitting a destination size, if drawing a mipmapped texture.
+        // Returns how much smaller the chosen level is than the full-size image.
+        coord::point select_level(coord::point dst_size);
+
+        const mip_texture* m_mips { nullptr };
     };
 }
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <halcyon/video/renderer.hpp>
+
+#include <span>
+#include <vector>
+
+// video/sprite_batch.hpp:
+// Many sprites from a single texture, drawn with a single call.
+
+namespace hal
+{
+    // A structure-of-arrays container of sprites sharing a texture (i.e. an atlas).
+    // Every attribute is stored in its own array, which can be updated in bulk
+    // (see types/batch.hpp) and converted to vertices without any per-sprite SDL calls.
+    // Sprites are drawn in the order they were added.
+    class sprite_batch
+    {
+    public:
+        using index_t = std::uint32_t;
+
+        // Queries the texture's size once; recreate the batch if the texture changes.
+        sprite_batch(ref<const texture> tx);
+
+        // Add an area of the texture sprites can be drawn from. Returns its index.
+        index_t add_source(pixel::rect src);
+
+        // Add a sprite. Returns its index.
+        // Rotation is in degrees, clockwise around the sprite's center.
+        index_t add(coord::rect dst, index_t source);
+        index_t add(coord::rect dst, index_t source, color tint, float rotation);
+
+        // Remove a sprite by moving the last one in its place.
+        // This changes the index (and drawing order) of the last sprite.
+        void remove(index_t sprite);
+
+        // Remove all sprites. Sources are kept.
+        void clear();
+
+        void        reserve(std::size_t n);
+        std::size_t size() const;
+        bool        empty() const;
+
+        // Direct access to sprite attributes, indexed by sprite.
+        std::span<coord_t> xs();
+        std::span<coord_t> ys();
+        std::span<coord_t> widths();
+        std::span<coord_t> heights();
+        std::span<index_t> sources();
+        std::span<color>   tints();
+        std::span<float>   rotations();
+
+        std::span<const coord_t> xs() const;
+        std::span<const coord_t> ys() const;
+        std::span<const coord_t> widths() const;
+        std::span<const coord_t> heights() const;
+        std::span<const index_t> sources() const;
+        std::span<const color>   tints() const;
+        std::span<const float>   rotations() const;
+
+        // Skip sprites that lie entirely outside of an area, i.e. `renderer::visible_area()`.
+        void cull(coord::rect area);
+        void reset_cull();
+
+        // Append four vertices and six indices for every (non-culled) sprite.
+        // Returns the amount of sprites written.
+        std::size_t build(std::vector<vertex>& vertices, std::vector<int>& indices) const;
+
+        // Build the vertices into internal buffers and draw all sprites at once.
+        bool render(lref<renderer> rnd);
+
+    private:
+        // Append four vertices per sprite; returns the amount of sprites written.
+        std::size_t append_vertices(std::vector<vertex>& out) const;
+
+        ref<const texture> m_texture;
+        coord::point       m_texSize;
+
+        std::vector<coord::rect> m_sources;
+
+        std::vector<coord_t> m_x, m_y, m_w, m_h;
+        std::vector<index_t> m_source;
+        std::vector<color>   m_tint;
+        std::vector<float>   m_rotation;
+
+        // Reused between renders.
+        std::vector<vertex> m_vertices;
+        std::vector<int>    m_indices;
+
+        coord::rect m_cullArea;
+        bool        m_cull;
+    };
+}
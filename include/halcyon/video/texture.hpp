@@ -13,6 +13,7 @@
 namespace hal
 {
     class surface;
+    class dirty_region;
 
     // Base texture class. Do not create directly.
     class texture : public detail::resource<SDL_Texture, &::SDL_DestroyTexture>
@@ -71,6 +72,10 @@ namespace hal
         // The surface's pixel format must match the texture's, and its size must be >= the area's.
         bool update(ref<const surface> surf, pixel::rect area);
 
+        // Update only the changed areas of the texture with pixels of a surface, which
+        // must have the same pixel format and size as the texture. Does not clear the region.
+        bool update(ref<const surface> surf, const dirty_region& region);
+
     private:
         bool internal_update(const SDL_Rect* area, const void* pixels, int pitch);
     };
@@ -107,6 +112,10 @@ namespace hal
 
         void unlock();
 
+        // Copy only the changed areas of a surface into the texture, locking each of them separately.
+        // The surface must have the same pixel format and size as the texture. Does not clear the region.
+        bool update(ref<const surface> surf, const dirty_region& region);
+
     private:
         result<lock_data> internal_lock(const SDL_Rect* area);
     };
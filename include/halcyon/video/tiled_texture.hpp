@@ -0,0 +1,62 @@
+#pragma once
+
+#include <halcyon/internal/iostream.hpp>
+#include <halcyon/video/texture.hpp>
+
+#include <vector>
+
+// video/tiled_texture.hpp:
+// Images larger than a single texture, split into a grid of them.
+
+namespace hal
+{
+    // An image stored as a grid of textures, for images larger than the renderer's
+    // maximum texture size (i.e. maps or panoramas).
+    // QOI images are decoded a few rows at a time and uploaded as they arrive, so that
+    // only a narrow band of the image is ever in memory. Other formats have to be
+    // loaded entirely before being split up.
+    class tiled_texture
+    {
+    public:
+        tiled_texture() = default;
+
+        // Load an image into tiles of a certain size. A size of zero
+        // uses the renderer's maximum texture size.
+        tiled_texture(lref<const renderer> rnd, accessor src, pixel_t tile_size = 0);
+
+        // Split a surface into tiles of a certain size.
+        tiled_texture(lref<const renderer> rnd, const surface& surf, pixel_t tile_size = 0);
+
+        // Draw the whole image into an area of the target. Tiles outside of the
+        // visible area are skipped. Scaling with linear filtering may show seams
+        // between tiles, since every tile is sampled on its own.
+        bool render(lref<renderer> rnd, coord::rect dst) const;
+
+        // Get the size of the full image.
+        pixel::point size() const;
+
+        // Get the amount of tiles in each direction.
+        pixel::point grid() const;
+
+        pixel_t tile_size() const;
+
+        // Get the tile at a grid position.
+        static_texture&       tile(pixel::point pos);
+        const static_texture& tile(pixel::point pos) const;
+
+        // Whether the whole image has been loaded.
+        bool valid() const;
+
+    private:
+        // Create empty tiles for an image of a certain size.
+        bool create(lref<const renderer> rnd, pixel::point size, pixel_t tile_size);
+
+        // Upload rows of RGBA32 pixels, starting at a row of the image.
+        bool upload(const std::uint8_t* pixels, int pitch, pixel_t rows, pixel_t first_row);
+
+        std::vector<static_texture> m_tiles;
+
+        pixel::point m_size { 0, 0 }, m_grid { 0, 0 };
+        pixel_t      m_tileSize { 0 };
+    };
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <halcyon/video/cached_layer.hpp>
+#include <halcyon/video/sprite_batch.hpp>
+
+#include <limits>
+#include <optional>
+#include <vector>
+
+// video/tilemap.hpp:
+// Large grids of tiles, drawn in pre-rendered chunks.
+
+namespace hal
+{
+    // A grid of tiles taken from a tileset (a texture with equally-sized tiles, row by row).
+    // The map is split into square chunks, each of which is baked into a `hal::cached_layer`
+    // the first time it becomes visible, and redrawn only when one of its tiles changes.
+    // Drawing the map thus costs one texture copy per visible chunk, regardless of tile count.
+    class tilemap
+    {
+    public:
+        using tile_t = std::uint16_t;
+
+        // A tile that isn't drawn.
+        constexpr static tile_t empty { std::numeric_limits<tile_t>::max() };
+
+        // Create an empty map. `size` is in tiles, `chunk_tiles` is the side length of a chunk in tiles.
+        tilemap(lref<renderer> rnd, ref<const texture> tileset, pixel::point tile_size, pixel::point size, pixel_t chunk_tiles = 32);
+
+        // Get/set a single tile. Setting a tile invalidates its chunk.
+        tile_t get(pixel::point pos) const;
+        void   set(pixel::point pos, tile_t tile);
+
+        // Replace all tiles, row by row. The span must contain exactly `size().product()` tiles.
+        void assign(std::span<const tile_t> tiles);
+
+        // Draw the part of the map that lies within `view` (in map pixels), with the view's
+        // position at the top left of the render target. Chunks are baked as needed.
+        bool render(coord::rect view);
+
+        // Limit the amount of baked chunks kept in memory; the ones that have gone unused
+        // the longest get discarded first. Zero (the default) means no limit.
+        void        max_baked_chunks(std::size_t n);
+        std::size_t max_baked_chunks() const;
+
+        // Get the amount of chunks currently baked.
+        std::size_t baked_chunks() const;
+
+        // Discard all baked chunks; they will be baked again when drawn.
+        void invalidate();
+
+        // Size in tiles.
+        pixel::point size() const;
+        pixel::point tile_size() const;
+
+    private:
+        struct chunk
+        {
+            std::optional<cached_layer> layer;
+
+            // The frame in which the chunk was last drawn.
+            std::uint64_t last_used;
+        };
+
+        chunk& chunk_at(pixel::point chunk_pos);
+
+        // Draw a chunk's tiles into the current target. Returns false if drawing failed.
+        bool bake(renderer& rnd, pixel::point chunk_pos);
+
+        // Discard baked chunks until there's room for one more.
+        void evict();
+
+        lref<renderer> m_renderer;
+
+        // Used for baking; holds a source for every tile in the tileset.
+        sprite_batch m_baker;
+
+        std::vector<tile_t> m_tiles;
+        std::vector<chunk>  m_chunks;
+
+        pixel::point m_size, m_tileSize, m_chunkCount;
+        pixel_t      m_chunkTiles;
+
+        // The amount of tiles in the tileset.
+        std::size_t m_tileCount;
+
+        std::size_t   m_maxBaked, m_baked;
+        std::uint64_t m_frame;
+    };
+}
@@ -600,6 +600,37 @@ namespace hal
         }
     }
 
+    // Filters for high-quality software resizing.
+    enum class resample_filter : std::uint8_t
+    {
+        box,      // Plain average of covered pixels; fastest, but soft.
+        bilinear, // Triangle filter, 2 taps when upscaling.
+        bicubic,  // Catmull-Rom spline, 4 taps when upscaling.
+        lanczos3, // Windowed sinc, 6 taps when upscaling.
+        kaiser    // Kaiser-windowed sinc, 6 taps when upscaling. Sharp, with little ringing.
+    };
+
+    constexpr std::string_view to_string(resample_filter rf)
+    {
+        using namespace std::string_view_literals;
+
+        switch (rf)
+        {
+        case resample_filter::box:
+            return "Box"sv;
+        case resample_filter::bilinear:
+            return "Bilinear"sv;
+        case resample_filter::bicubic:
+            return "Bicubic"sv;
+        case resample_filter::lanczos3:
+            return "Lanczos-3"sv;
+        case resample_filter::kaiser:
+            return "Kaiser"sv;
+        default:
+            return "[unknown]"sv;
+        }
+    }
+
     namespace pixel
     {
         template <typename T>
@@ -2,49 +2,164 @@
 
 #include <halcyon/image.hpp>
 
+#include <halcyon/internal/qoi.hpp>
 #include <halcyon/types/exception.hpp>
 
+#include <array>
+#include <cctype>
+
 using namespace hal;
 
+namespace
+{
+    using namespace std::string_view_literals;
+
+    // Formats are recognized by their first few bytes, like SDL_image's `IMG_is*()`
+    // functions do, but with a single read for all of them.
+    struct magic
+    {
+        image::load_format format;
+
+        // Bytes at the start of the file, and optionally more at an offset.
+        std::string_view head;
+        std::size_t      offset { 0 };
+        std::string_view tail {};
+    };
+
+    constexpr std::size_t sniff_size { 32 };
+
+    constexpr magic magics[] {
+        { image::load_format::png, "\x89PNG\r\n\x1A\n"sv },
+        { image::load_format::jpg, "\xFF\xD8\xFF"sv },
+        { image::load_format::qoi, "qoif"sv },
+        { image::load_format::webp, "RIFF"sv, 8, "WEBP"sv },
+        { image::load_format::gif, "GIF87a"sv },
+        { image::load_format::gif, "GIF89a"sv },
+        { image::load_format::bmp, "BM"sv },
+        { image::load_format::avif, ""sv, 4, "ftypavif"sv },
+        { image::load_format::avif, ""sv, 4, "ftypavis"sv },
+        { image::load_format::jxl, "\xFF\x0A"sv },
+        { image::load_format::jxl, "\0\0\0\x0CJXL \r\n\x87\n"sv },
+        { image::load_format::tif, "II*\0"sv },
+        { image::load_format::tif, "MM\0*"sv },
+        { image::load_format::lbm, "FORM"sv, 8, "ILBM"sv },
+        { image::load_format::lbm, "FORM"sv, 8, "PBM "sv },
+        { image::load_format::xcf, "gimp xcf "sv },
+        { image::load_format::xpm, "/* XPM */"sv },
+        { image::load_format::xv, "P7 332"sv }
+    };
+
+    bool matches(std::string_view data, const magic& m)
+    {
+        return data.starts_with(m.head) && (m.tail.empty() || (data.size() >= m.offset && data.substr(m.offset).starts_with(m.tail)));
+    }
+
+    // Formats whose signatures aren't fixed strings.
+    image::load_format sniff_special(std::string_view data)
+    {
+        const auto byte = [&](std::size_t i)
+        {
+            return static_cast<unsigned char>(data[i]);
+        };
+
+        // "P1" to "P6", followed by whitespace.
+        if (data.size() >= 3 && data[0] == 'P' && data[1] >= '1' && data[1] <= '6' && std::isspace(byte(2)))
+            return image::load_format::pnm;
+
+        // A reserved zero, the resource type and a nonzero image count. The
+        // count keeps uncompressed TGA files from being mistaken for cursors.
+        if (data.size() >= 6 && byte(0) == 0 && byte(1) == 0 && (byte(2) == 1 || byte(2) == 2) && byte(3) == 0 && (byte(4) | byte(5)) != 0)
+            return byte(2) == 1 ? image::load_format::ico : image::load_format::cur;
+
+        // ZSoft's manufacturer byte, a known version and RLE encoding.
+        if (data.size() >= 3 && byte(0) == 0x0A && byte(1) <= 5 && byte(1) != 1 && byte(2) == 1)
+            return image::load_format::pcx;
+
+        return image::load_format::unknown;
+    }
+
+    image::load_format sniff(SDL_IOStream* src)
+    {
+        const Sint64 start { ::SDL_TellIO(src) };
+
+        if (start < 0)
+            return image::load_format::unknown;
+
+        std::array<char, sniff_size> buf;
+
+        const std::size_t read { ::SDL_ReadIO(src, buf.data(), buf.size()) };
+        ::SDL_SeekIO(src, start, SDL_IO_SEEK_SET);
+
+        const std::string_view data { buf.data(), read };
+
+        for (const magic& m : magics)
+            if (matches(data, m))
+                return m.format;
+
+        return sniff_special(data);
+    }
+
+    // The type-specific loaders don't close the stream; the accessor does.
+    SDL_Surface* load_as(SDL_IOStream* src, image::load_format fmt)
+    {
+        using enum image::load_format;
+
+        struct
+        {
+            image::load_format                    format;
+            func_ref<SDL_Surface*, SDL_IOStream*> func;
+        } constexpr dispatch[] {
+            { jpg, ::IMG_LoadJPG_IO },
+            { png, ::IMG_LoadPNG_IO },
+            { tif, ::IMG_LoadTIF_IO },
+            { webp, ::IMG_LoadWEBP_IO },
+            { jxl, ::IMG_LoadJXL_IO },
+            { avif, ::IMG_LoadAVIF_IO },
+            { ico, ::IMG_LoadICO_IO },
+            { cur, ::IMG_LoadCUR_IO },
+            { bmp, ::IMG_LoadBMP_IO },
+            { gif, ::IMG_LoadGIF_IO },
+            { lbm, ::IMG_LoadLBM_IO },
+            { pcx, ::IMG_LoadPCX_IO },
+            { pnm, ::IMG_LoadPNM_IO },
+            { svg, ::IMG_LoadSVG_IO },
+            { qoi, ::IMG_LoadQOI_IO },
+            { xcf, ::IMG_LoadXCF_IO },
+            { xpm, ::IMG_LoadXPM_IO },
+            { xv, ::IMG_LoadXV_IO }
+        };
+
+        for (const auto& pair : dispatch)
+            if (pair.format == fmt)
+                return pair.func(src);
+
+        return nullptr;
+    }
+}
+
 surface image::load(accessor src)
 {
+    // SVG files can start with any amount of XML, so they're left to SDL_image.
+    if (const load_format fmt { sniff(src.get()) }; fmt != load_format::unknown)
+    {
+        const Sint64 start { ::SDL_TellIO(src.get()) };
+
+        if (surface ret { load_as(src.get(), fmt) }; ret.valid())
+            return ret;
+
+        // A file that merely looks like another format still gets a chance.
+        ::SDL_SeekIO(src.get(), start, SDL_IO_SEEK_SET);
+    }
+
     return ::IMG_Load_IO(src.release(), true);
 }
 
 surface image::load(accessor src, load_format fmt)
 {
-    using enum load_format;
+    if (fmt == load_format::unknown)
+        HAL_PANIC("Trying to load image of unknown type");
 
-    struct
-    {
-        load_format                           format;
-        func_ref<SDL_Surface*, SDL_IOStream*> func;
-    } constexpr dispatch[] {
-        { jpg, ::IMG_LoadPNG_IO },
-        { png, ::IMG_LoadPNG_IO },
-        { tif, ::IMG_LoadTIF_IO },
-        { webp, ::IMG_LoadWEBP_IO },
-        { jxl, ::IMG_LoadJXL_IO },
-        { avif, ::IMG_LoadAVIF_IO },
-        { ico, ::IMG_LoadICO_IO },
-        { cur, ::IMG_LoadCUR_IO },
-        { bmp, ::IMG_LoadBMP_IO },
-        { gif, ::IMG_LoadGIF_IO },
-        { lbm, ::IMG_LoadLBM_IO },
-        { pcx, ::IMG_LoadPCX_IO },
-        { pnm, ::IMG_LoadPNM_IO },
-        { svg, ::IMG_LoadSVG_IO },
-        { qoi, ::IMG_LoadQOI_IO },
-        { xcf, ::IMG_LoadXCF_IO },
-        { xpm, ::IMG_LoadXPM_IO },
-        { xv, ::IMG_LoadXV_IO }
-    };
-
-    for (const auto& pair : dispatch)
-        if (pair.format == fmt)
-            return pair.func(src.release());
-
-    HAL_PANIC("Trying to load image of unknown type");
+    return load_as(src.get(), fmt);
 }
 
 bool image::save::png(ref<const surface> surf, outputter dst)
@@ -62,38 +177,21 @@ bool image::save::avif(ref<const surface> surf, outputter dst, std::uint8_t qual
     return ::IMG_SaveAVIF_IO(surf.get(), dst.get(), false, quality);
 }
 
-image::load_format image::query(const accessor& src)
+bool image::save::qoi(ref<const surface> surf, outputter dst)
 {
-    using enum load_format;
+    return detail::write_qoi(surf(), dst.get());
+}
 
-    struct
-    {
-        func_ref<bool, SDL_IOStream*> func;
-        load_format                   format;
-    } constexpr dispatch[] {
-        { ::IMG_isAVIF, avif },
-        { ::IMG_isICO, ico },
-        { ::IMG_isCUR, cur },
-        { ::IMG_isBMP, bmp },
-        { ::IMG_isGIF, gif },
-        { ::IMG_isJPG, jpg },
-        { ::IMG_isJXL, jxl },
-        { ::IMG_isLBM, lbm },
-        { ::IMG_isPCX, pcx },
-        { ::IMG_isPNG, png },
-        { ::IMG_isPNM, pnm },
-        { ::IMG_isSVG, svg },
-        { ::IMG_isQOI, qoi },
-        { ::IMG_isTIF, tif },
-        { ::IMG_isXCF, xcf },
-        { ::IMG_isXPM, xpm },
-        { ::IMG_isXV, xv },
-        { ::IMG_isWEBP, webp }
-    };
+bool image::save::qoi(ref<const surface> surf, outputter dst, thread_pool& pool)
+{
+    return detail::write_qoi(surf(), dst.get(), pool);
+}
 
-    for (const auto& pair : dispatch)
-        if (pair.func(src.get()) != 0)
-            return pair.format;
+image::load_format image::query(const accessor& src)
+{
+    if (const load_format fmt { sniff(src.get()) }; fmt != load_format::unknown)
+        return fmt;
 
-    return unknown;
+    // The only format that can't be told by its first bytes.
+    return ::IMG_isSVG(src.get()) ? load_format::svg : load_format::unknown;
 }
@@ -0,0 +1,269 @@
+#include <halcyon/internal/convert.hpp>
+
+#include <halcyon/internal/simd.hpp>
+#include <halcyon/system.hpp>
+
+#include <array>
+#include <cstring>
+
+using namespace hal;
+
+namespace
+{
+    // Convert a row of `n` pixels.
+    using row_func = void (*)(const std::uint8_t* src, std::uint8_t* dst, int n);
+
+    void convert_rows(const SDL_Surface& src, SDL_Surface& dst, row_func func)
+    {
+        const auto* s = static_cast<const std::uint8_t*>(src.pixels);
+        auto*       d = static_cast<std::uint8_t*>(dst.pixels);
+
+        for (int y { 0 }; y < src.h; ++y, s += src.pitch, d += dst.pitch)
+            func(s, d, src.w);
+    }
+
+    // ----- SCALAR -----
+
+    // RGBA32 is an array format (its bytes are always in RGBA order), whereas the others
+    // are packed into native-endian integers. Going through integers keeps these portable.
+
+    void rgba32_to_argb8888_scalar(const std::uint8_t* src, std::uint8_t* dst, int n)
+    {
+        for (int i { 0 }; i < n; ++i, src += 4, dst += 4)
+        {
+            const std::uint32_t v { std::uint32_t(src[3]) << 24 | std::uint32_t(src[0]) << 16 | std::uint32_t(src[1]) << 8 | src[2] };
+            std::memcpy(dst, &v, 4);
+        }
+    }
+
+    void argb8888_to_rgba32_scalar(const std::uint8_t* src, std::uint8_t* dst, int n)
+    {
+        for (int i { 0 }; i < n; ++i, src += 4, dst += 4)
+        {
+            std::uint32_t v;
+            std::memcpy(&v, src, 4);
+
+            dst[0] = static_cast<std::uint8_t>(v >> 16);
+            dst[1] = static_cast<std::uint8_t>(v >> 8);
+            dst[2] = static_cast<std::uint8_t>(v);
+            dst[3] = static_cast<std::uint8_t>(v >> 24);
+        }
+    }
+
+    void rgb24_to_rgba32_scalar(const std::uint8_t* src, std::uint8_t* dst, int n)
+    {
+        for (int i { 0 }; i < n; ++i, src += 3, dst += 4)
+        {
+            dst[0] = src[0];
+            dst[1] = src[1];
+            dst[2] = src[2];
+            dst[3] = 0xFF;
+        }
+    }
+
+    // Truncates, like SDL's own blitters.
+    void rgba32_to_rgb565_scalar(const std::uint8_t* src, std::uint8_t* dst, int n)
+    {
+        for (int i { 0 }; i < n; ++i, src += 4, dst += 2)
+        {
+            const std::uint16_t v = static_cast<std::uint16_t>((src[0] >> 3) << 11 | (src[1] >> 2) << 5 | src[2] >> 3);
+            std::memcpy(dst, &v, 2);
+        }
+    }
+
+#ifdef HAL_SIMD_X86
+    // x86 is little endian, so converting between RGBA32 and ARGB8888 is a matter of
+    // swapping the first and third byte of every pixel, in either direction.
+    HAL_TARGET_SSE2 void swap_rb_sse2(const std::uint8_t* src, std::uint8_t* dst, int n)
+    {
+        const __m128i ga { _mm_set1_epi32(static_cast<int>(0xFF00FF00)) }, low { _mm_set1_epi32(0xFF) };
+
+        int i { 0 };
+
+        for (; i + 4 <= n; i += 4)
+        {
+            const __m128i v { _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4)) };
+
+            const __m128i r { _mm_and_si128(v, low) };
+            const __m128i b { _mm_and_si128(_mm_srli_epi32(v, 16), low) };
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_or_si128(_mm_and_si128(v, ga), _mm_or_si128(b, _mm_slli_epi32(r, 16))));
+        }
+
+        for (src += i * 4, dst += i * 4; i < n; ++i, src += 4, dst += 4)
+        {
+            dst[0] = src[2];
+            dst[1] = src[1];
+            dst[2] = src[0];
+            dst[3] = src[3];
+        }
+    }
+
+    // Four RGBA32 pixels to RGB565 values in the low halves of 32-bit lanes.
+    HAL_TARGET_SSE2 __m128i to_rgb565_sse2(__m128i v)
+    {
+        const __m128i r { _mm_slli_epi32(_mm_and_si128(v, _mm_set1_epi32(0xF8)), 8) };
+        const __m128i g { _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(v, 8), _mm_set1_epi32(0xFC)), 3) };
+        const __m128i b { _mm_srli_epi32(_mm_and_si128(_mm_srli_epi32(v, 16), _mm_set1_epi32(0xF8)), 3) };
+
+        return _mm_or_si128(r, _mm_or_si128(g, b));
+    }
+
+    HAL_TARGET_SSE2 void rgba32_to_rgb565_sse2(const std::uint8_t* src, std::uint8_t* dst, int n)
+    {
+        // SSE2 can only pack with signed saturation, so values are moved into its range and back.
+        const __m128i bias32 { _mm_set1_epi32(0x8000) };
+        const __m128i bias16 { _mm_set1_epi16(static_cast<short>(0x8000)) };
+
+        int i { 0 };
+
+        for (; i + 8 <= n; i += 8)
+        {
+            const __m128i lo { to_rgb565_sse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4))) };
+            const __m128i hi { to_rgb565_sse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4 + 16))) };
+
+            const __m128i packed { _mm_packs_epi32(_mm_sub_epi32(lo, bias32), _mm_sub_epi32(hi, bias32)) };
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 2), _mm_xor_si128(packed, bias16));
+        }
+
+        rgba32_to_rgb565_scalar(src + i * 4, dst + i * 2, n - i);
+    }
+
+    HAL_TARGET_SSSE3 void rgb24_to_rgba32_ssse3(const std::uint8_t* src, std::uint8_t* dst, int n)
+    {
+        const __m128i shuffle { _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1) };
+        const __m128i alpha { _mm_set1_epi32(static_cast<int>(0xFF000000)) };
+
+        int i { 0 };
+
+        // Every load reads 16 bytes (five and a third pixels), but only converts four.
+        for (; i + 6 <= n; i += 4)
+        {
+            const __m128i v { _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 3)) };
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_or_si128(_mm_shuffle_epi8(v, shuffle), alpha));
+        }
+
+        rgb24_to_rgba32_scalar(src + i * 3, dst + i * 4, n - i);
+    }
+#endif
+
+    // ----- REGISTRY -----
+
+    struct convert_entry
+    {
+        pixel::format        from, to;
+        detail::convert_func func;
+    };
+
+    template <pixel::format From, pixel::format To>
+        requires detail::has_fast_convert<From, To>
+    constexpr convert_entry entry()
+    {
+        return { From, To, &detail::fast_convert<From, To>::convert };
+    }
+
+    constexpr std::array conversions {
+        entry<pixel::format::rgba32, pixel::format::argb8888>(),
+        entry<pixel::format::argb8888, pixel::format::rgba32>(),
+        entry<pixel::format::rgb24, pixel::format::rgba32>(),
+        entry<pixel::format::rgba32, pixel::format::rgb565>(),
+        entry<pixel::format::index8, pixel::format::rgba32>()
+    };
+}
+
+// Row functions are chosen once per conversion, upon first use.
+
+bool detail::fast_convert<pixel::format::rgba32, pixel::format::argb8888>::convert(const SDL_Surface& src, SDL_Surface& dst)
+{
+#ifdef HAL_SIMD_X86
+    static const row_func func { cpu::sse2() ? swap_rb_sse2 : rgba32_to_argb8888_scalar };
+#else
+    constexpr row_func func { rgba32_to_argb8888_scalar };
+#endif
+
+    convert_rows(src, dst, func);
+
+    return true;
+}
+
+bool detail::fast_convert<pixel::format::argb8888, pixel::format::rgba32>::convert(const SDL_Surface& src, SDL_Surface& dst)
+{
+#ifdef HAL_SIMD_X86
+    static const row_func func { cpu::sse2() ? swap_rb_sse2 : argb8888_to_rgba32_scalar };
+#else
+    constexpr row_func func { argb8888_to_rgba32_scalar };
+#endif
+
+    convert_rows(src, dst, func);
+
+    return true;
+}
+
+bool detail::fast_convert<pixel::format::rgb24, pixel::format::rgba32>::convert(const SDL_Surface& src, SDL_Surface& dst)
+{
+#ifdef HAL_SIMD_X86
+    // SDL can't detect SSSE3 by itself, but every CPU with SSE4.1 has it.
+    static const row_func func { cpu::sse4_1() ? rgb24_to_rgba32_ssse3 : rgb24_to_rgba32_scalar };
+#else
+    constexpr row_func func { rgb24_to_rgba32_scalar };
+#endif
+
+    convert_rows(src, dst, func);
+
+    return true;
+}
+
+bool detail::fast_convert<pixel::format::rgba32, pixel::format::rgb565>::convert(const SDL_Surface& src, SDL_Surface& dst)
+{
+#ifdef HAL_SIMD_X86
+    static const row_func func { cpu::sse2() ? rgba32_to_rgb565_sse2 : rgba32_to_rgb565_scalar };
+#else
+    constexpr row_func func { rgba32_to_rgb565_scalar };
+#endif
+
+    convert_rows(src, dst, func);
+
+    return true;
+}
+
+bool detail::fast_convert<pixel::format::index8, pixel::format::rgba32>::convert(const SDL_Surface& src, SDL_Surface& dst)
+{
+    const SDL_Palette* pal { ::SDL_GetSurfacePalette(const_cast<SDL_Surface*>(&src)) };
+
+    if (pal == nullptr)
+        return false;
+
+    // Indices outside of the palette become opaque black.
+    std::array<std::uint32_t, 256> lut;
+    lut.fill(0);
+
+    for (std::size_t i { 0 }; i < lut.size(); ++i)
+    {
+        const SDL_Color c { i < static_cast<std::size_t>(pal->ncolors) ? pal->colors[i] : SDL_Color { 0, 0, 0, 0xFF } };
+        const std::uint8_t bytes[4] { c.r, c.g, c.b, c.a };
+
+        std::memcpy(&lut[i], bytes, 4);
+    }
+
+    const auto* s = static_cast<const std::uint8_t*>(src.pixels);
+    auto*       d = static_cast<std::uint8_t*>(dst.pixels);
+
+    for (int y { 0 }; y < src.h; ++y, s += src.pitch, d += dst.pitch)
+        for (int x { 0 }; x < src.w; ++x)
+            std::memcpy(d + x * 4, &lut[s[x]], 4);
+
+    return true;
+}
+
+detail::convert_func detail::find_convert(pixel::format from, pixel::format to)
+{
+    for (const convert_entry& e : conversions)
+    {
+        if (e.from == from && e.to == to)
+            return e.func;
+    }
+
+    return nullptr;
+}
@@ -0,0 +1,468 @@
+#include <halcyon/internal/qoi.hpp>
+
+#include <halcyon/surface.hpp>
+#include <halcyon/utility/thread_pool.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <span>
+
+using namespace hal;
+
+namespace
+{
+    // See https://qoiformat.org/qoi-specification.pdf.
+    enum op : std::uint8_t
+    {
+        op_index = 0x00,
+        op_diff  = 0x40,
+        op_luma  = 0x80,
+        op_run   = 0xC0,
+        op_rgb   = 0xFE,
+        op_rgba  = 0xFF
+    };
+
+    constexpr std::uint8_t max_run { 62 };
+
+    constexpr std::array<std::uint8_t, 8> end_marker { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+    struct rgba
+    {
+        std::uint8_t r, g, b, a;
+
+        friend bool operator==(rgba, rgba) = default;
+    };
+
+    std::size_t hash(rgba px)
+    {
+        return (px.r * 3 + px.g * 5 + px.b * 7 + px.a * 11) % 64;
+    }
+
+    // The decoder reads this much at once.
+    constexpr std::size_t read_chunk { 64 * 1024 };
+
+    constexpr std::size_t header_size { 14 };
+
+    std::uint32_t get32(const std::uint8_t* in)
+    {
+        return std::uint32_t(in[0]) << 24 | std::uint32_t(in[1]) << 16 | std::uint32_t(in[2]) << 8 | in[3];
+    }
+
+    void put32(std::vector<std::uint8_t>& out, std::uint32_t val)
+    {
+        out.push_back(static_cast<std::uint8_t>(val >> 24));
+        out.push_back(static_cast<std::uint8_t>(val >> 16));
+        out.push_back(static_cast<std::uint8_t>(val >> 8));
+        out.push_back(static_cast<std::uint8_t>(val));
+    }
+
+    // Encode some rows, continuing from the pixel before them. The decoder's color index
+    // at that point isn't known unless these are the first rows, so only slots set
+    // here are looked up; every stream of ops produced this way is still valid.
+    void encode_strip(const std::uint8_t* pixels, pixel_t width, int pitch, pixel_t first_row, pixel_t rows, std::vector<std::uint8_t>& out)
+    {
+        std::array<rgba, 64> index {};
+
+        // The decoder's index starts out zeroed, so the first strip can use all of it.
+        std::uint64_t known { first_row == 0 ? ~std::uint64_t(0) : 0 };
+
+        rgba         prev { 0, 0, 0, 0xFF };
+        std::uint8_t run { 0 };
+
+        if (first_row > 0)
+        {
+            const std::uint8_t* last { pixels + std::ptrdiff_t(first_row - 1) * pitch + (width - 1) * 4 };
+            prev = { last[0], last[1], last[2], last[3] };
+        }
+
+        for (pixel_t y { first_row }; y < first_row + rows; ++y)
+        {
+            const std::uint8_t* row { pixels + std::ptrdiff_t(y) * pitch };
+
+            for (pixel_t x { 0 }; x < width; ++x)
+            {
+                const rgba px { row[x * 4], row[x * 4 + 1], row[x * 4 + 2], row[x * 4 + 3] };
+
+                if (px == prev)
+                {
+                    if (++run == max_run)
+                    {
+                        out.push_back(static_cast<std::uint8_t>(op_run | (run - 1)));
+                        run = 0;
+                    }
+
+                    continue;
+                }
+
+                if (run > 0)
+                {
+                    out.push_back(static_cast<std::uint8_t>(op_run | (run - 1)));
+                    run = 0;
+                }
+
+                const std::size_t h { hash(px) };
+
+                if ((known >> h & 1) != 0 && index[h] == px)
+                    out.push_back(static_cast<std::uint8_t>(op_index | h));
+
+                else
+                {
+                    index[h] = px;
+                    known |= std::uint64_t(1) << h;
+
+                    if (px.a == prev.a)
+                    {
+                        // Differences wrap around, as per the specification.
+                        const int dr { static_cast<std::int8_t>(px.r - prev.r) };
+                        const int dg { static_cast<std::int8_t>(px.g - prev.g) };
+                        const int db { static_cast<std::int8_t>(px.b - prev.b) };
+
+                        const int dr_dg { dr - dg }, db_dg { db - dg };
+
+                        if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+                            out.push_back(static_cast<std::uint8_t>(op_diff | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+
+                        else if (dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7)
+                        {
+                            out.push_back(static_cast<std::uint8_t>(op_luma | (dg + 32)));
+                            out.push_back(static_cast<std::uint8_t>((dr_dg + 8) << 4 | (db_dg + 8)));
+                        }
+
+                        else
+                            out.insert(out.end(), { op_rgb, px.r, px.g, px.b });
+                    }
+
+                    else
+                        out.insert(out.end(), { op_rgba, px.r, px.g, px.b, px.a });
+                }
+
+                prev = px;
+            }
+        }
+
+        // Runs don't carry over into the next strip.
+        if (run > 0)
+            out.push_back(static_cast<std::uint8_t>(op_run | (run - 1)));
+    }
+
+    void put_header(std::vector<std::uint8_t>& out, pixel::point size)
+    {
+        out.insert(out.end(), { 'q', 'o', 'i', 'f' });
+        put32(out, static_cast<std::uint32_t>(size.x));
+        put32(out, static_cast<std::uint32_t>(size.y));
+        out.push_back(4); // Channels.
+        out.push_back(0); // sRGB with linear alpha.
+    }
+
+    // Encode a whole image, passing the header, strips and end marker to `write` in order.
+    // Strips are written as soon as all previous ones have been, so only those finished
+    // ahead of their turn are held in memory.
+    template <typename F>
+    bool encode(const std::uint8_t* pixels, pixel::point size, int pitch, thread_pool* pool, F&& write)
+    {
+        // Strips shorter than this aren't worth handing to another thread.
+        constexpr pixel_t min_strip_rows { 32 };
+
+        std::size_t strips { 1 };
+
+        // A few strips per thread even out differences in how well they compress.
+        if (pool != nullptr)
+            strips = std::clamp<std::size_t>(size.y / min_strip_rows, 1, (pool->size() + 1) * 4);
+
+        std::vector<std::uint8_t> header;
+        put_header(header, size);
+
+        bool ret { write(header) };
+
+        if (strips == 1)
+        {
+            std::vector<std::uint8_t> out;
+
+            // Most images compress well; this just avoids the first few reallocations.
+            out.reserve(std::size_t(size.x) * size.y);
+            encode_strip(pixels, size.x, pitch, 0, size.y, out);
+
+            ret = ret && write(out);
+        }
+
+        else
+        {
+            std::vector<std::vector<std::uint8_t>> parts(strips);
+            std::vector<bool>                      done(strips);
+
+            std::mutex  mutex;
+            std::size_t next { 0 };
+
+            pool->for_each(strips, [&](std::size_t i)
+                {
+                    const pixel_t first { static_cast<pixel_t>(size.y * i / strips) };
+                    const pixel_t last { static_cast<pixel_t>(size.y * (i + 1) / strips) };
+
+                    std::vector<std::uint8_t> part;
+                    part.reserve(std::size_t(size.x) * (last - first));
+                    encode_strip(pixels, size.x, pitch, first, last - first, part);
+
+                    std::lock_guard _ { mutex };
+
+                    parts[i] = std::move(part);
+                    done[i]  = true;
+
+                    // Write whatever is next in line; later strips wait for the one in front of them.
+                    for (; next < strips && done[next]; ++next)
+                    {
+                        ret = ret && write(parts[next]);
+                        parts[next] = {};
+                    }
+                });
+        }
+
+        return ret && write(end_marker);
+    }
+
+    template <typename F>
+    bool encode(const surface& surf, thread_pool* pool, F&& write)
+    {
+        if (surf.pixel_format() != pixel::format::rgba32 || surf.must_lock())
+        {
+            const surface cvt { surf.convert(pixel::format::rgba32) };
+
+            return cvt.valid() && encode(cvt, pool, write);
+        }
+
+        return encode(static_cast<const std::uint8_t*>(surf->pixels), surf.size(), surf->pitch, pool, write);
+    }
+
+    // Collect the whole image in memory.
+    class to_vector
+    {
+    public:
+        to_vector(std::vector<std::uint8_t>& out)
+            : m_out { out }
+        {
+        }
+
+        bool operator()(std::span<const std::uint8_t> data)
+        {
+            m_out.insert(m_out.end(), data.begin(), data.end());
+            return true;
+        }
+
+    private:
+        std::vector<std::uint8_t>& m_out;
+    };
+
+    std::vector<std::uint8_t> encode_to_vector(const std::uint8_t* pixels, pixel::point size, int pitch, thread_pool* pool)
+    {
+        std::vector<std::uint8_t> ret;
+        ret.reserve(header_size + std::size_t(size.x) * size.y + end_marker.size());
+
+        encode(pixels, size, pitch, pool, to_vector { ret });
+
+        return ret;
+    }
+
+    std::vector<std::uint8_t> encode_to_vector(const surface& surf, thread_pool* pool)
+    {
+        std::vector<std::uint8_t> ret;
+
+        if (!encode(surf, pool, to_vector { ret }))
+            ret.clear();
+
+        return ret;
+    }
+
+    bool encode_to_stream(const surface& surf, SDL_IOStream* dst, thread_pool* pool)
+    {
+        return encode(surf, pool, [dst](std::span<const std::uint8_t> data)
+            { return ::SDL_WriteIO(dst, data.data(), data.size()) == data.size(); });
+    }
+}
+
+std::vector<std::uint8_t> detail::encode_qoi(const std::uint8_t* pixels, pixel::point size, int pitch)
+{
+    return encode_to_vector(pixels, size, pitch, nullptr);
+}
+
+std::vector<std::uint8_t> detail::encode_qoi(const std::uint8_t* pixels, pixel::point size, int pitch, thread_pool& pool)
+{
+    return encode_to_vector(pixels, size, pitch, &pool);
+}
+
+std::vector<std::uint8_t> detail::encode_qoi(const surface& surf)
+{
+    return encode_to_vector(surf, nullptr);
+}
+
+std::vector<std::uint8_t> detail::encode_qoi(const surface& surf, thread_pool& pool)
+{
+    return encode_to_vector(surf, &pool);
+}
+
+bool detail::write_qoi(const surface& surf, SDL_IOStream* dst)
+{
+    return encode_to_stream(surf, dst, nullptr);
+}
+
+bool detail::write_qoi(const surface& surf, SDL_IOStream* dst, thread_pool& pool)
+{
+    return encode_to_stream(surf, dst, &pool);
+}
+
+detail::qoi_decoder::qoi_decoder(SDL_IOStream* src)
+    : m_src { src }
+    , m_buffer(read_chunk)
+    , m_pos { 0 }
+    , m_end { 0 }
+    , m_size { 0, 0 }
+    , m_rowsLeft { 0 }
+    , m_index {}
+    , m_prev { 0, 0, 0, 0xFF }
+    , m_run { 0 }
+    , m_valid { false }
+{
+    if (m_src == nullptr || !fill(header_size))
+        return;
+
+    const std::uint8_t* header { m_buffer.data() + m_pos };
+
+    const std::uint32_t w { get32(header + 4) }, h { get32(header + 8) };
+
+    constexpr std::uint32_t max_size { std::numeric_limits<pixel_t>::max() };
+
+    if (std::memcmp(header, "qoif", 4) != 0 || w == 0 || h == 0 || w > max_size || h > max_size || (header[12] != 3 && header[12] != 4) || header[13] > 1)
+        return;
+
+    m_pos += header_size;
+
+    m_size     = { static_cast<pixel_t>(w), static_cast<pixel_t>(h) };
+    m_rowsLeft = m_size.y;
+    m_valid    = true;
+}
+
+bool detail::qoi_decoder::valid() const
+{
+    return m_valid;
+}
+
+pixel::point detail::qoi_decoder::size() const
+{
+    return m_size;
+}
+
+bool detail::qoi_decoder::read(std::uint8_t* dst, int pitch, pixel_t rows)
+{
+    if (!m_valid || rows > m_rowsLeft)
+        return false;
+
+    for (pixel_t y { 0 }; y < rows; ++y, dst += pitch)
+    {
+        for (pixel_t x { 0 }; x < m_size.x; ++x)
+        {
+            if (m_run > 0)
+                --m_run;
+
+            else
+            {
+                // Every op is complete before it's decoded; its tag tells how long it is.
+                if (!fill(1))
+                {
+                    m_valid = false;
+                    return false;
+                }
+
+                const std::uint8_t tag { m_buffer[m_pos] };
+
+                std::size_t len { 1 };
+
+                if (tag == op_rgb)
+                    len = 4;
+
+                else if (tag == op_rgba)
+                    len = 5;
+
+                else if ((tag & 0xC0) == op_luma)
+                    len = 2;
+
+                if (!fill(len))
+                {
+                    m_valid = false;
+                    return false;
+                }
+
+                const std::uint8_t* op { m_buffer.data() + m_pos };
+                m_pos += len;
+
+                if (tag == op_rgb)
+                    std::copy_n(op + 1, 3, m_prev.begin());
+
+                else if (tag == op_rgba)
+                    std::copy_n(op + 1, 4, m_prev.begin());
+
+                else
+                {
+                    switch (tag & 0xC0)
+                    {
+                    case op_index:
+                        m_prev = m_index[tag];
+                        break;
+
+                    case op_diff:
+                        m_prev[0] = static_cast<std::uint8_t>(m_prev[0] + (tag >> 4 & 3) - 2);
+                        m_prev[1] = static_cast<std::uint8_t>(m_prev[1] + (tag >> 2 & 3) - 2);
+                        m_prev[2] = static_cast<std::uint8_t>(m_prev[2] + (tag & 3) - 2);
+                        break;
+
+                    case op_luma:
+                    {
+                        const int dg { (tag & 0x3F) - 32 };
+
+                        m_prev[0] = static_cast<std::uint8_t>(m_prev[0] + dg - 8 + (op[1] >> 4));
+                        m_prev[1] = static_cast<std::uint8_t>(m_prev[1] + dg);
+                        m_prev[2] = static_cast<std::uint8_t>(m_prev[2] + dg - 8 + (op[1] & 0x0F));
+                        break;
+                    }
+
+                    default:
+                        m_run = tag & 0x3F;
+                        break;
+                    }
+                }
+
+                m_index[hash({ m_prev[0], m_prev[1], m_prev[2], m_prev[3] })] = m_prev;
+            }
+
+            std::copy_n(m_prev.begin(), 4, dst + x * 4);
+        }
+    }
+
+    m_rowsLeft -= rows;
+
+    return true;
+}
+
+bool detail::qoi_decoder::fill(std::size_t needed)
+{
+    if (m_end - m_pos >= needed)
+        return true;
+
+    // Move what's left to the front and read more after it.
+    std::copy(m_buffer.begin() + m_pos, m_buffer.begin() + m_end, m_buffer.begin());
+
+    m_end -= m_pos;
+    m_pos = 0;
+
+    while (m_end < needed)
+    {
+        const std::size_t read { ::SDL_ReadIO(m_src, m_buffer.data() + m_end, m_buffer.size() - m_end) };
+
+        if (read == 0)
+            return false;
+
+        m_end += read;
+    }
+
+    return true;
+}
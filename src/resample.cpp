@@ -0,0 +1,473 @@
+#include <halcyon/surface.hpp>
+
+#include <halcyon/internal/simd.hpp>
+#include <halcyon/system.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numbers>
+#include <vector>
+
+// Separable resampling for `surface::resize()`.
+// Pixels are converted to premultiplied RGBA floats and filtered horizontally into
+// a small window of rows, which is then filtered vertically into the result.
+
+using namespace hal;
+
+namespace
+{
+    // ----- FILTERS -----
+
+    float sinc(float x)
+    {
+        constexpr float pi { std::numbers::pi_v<float> };
+
+        return std::abs(x) < 1e-6f ? 1.0f : std::sin(pi * x) / (pi * x);
+    }
+
+    // The modified Bessel function of the first kind, of order zero.
+    float bessel_i0(float x)
+    {
+        float sum { 1.0f }, term { 1.0f };
+
+        for (int k { 1 }; k < 32 && term > sum * 1e-7f; ++k)
+        {
+            const float t { x / (2.0f * static_cast<float>(k)) };
+
+            term *= t * t;
+            sum += term;
+        }
+
+        return sum;
+    }
+
+    float box(float x)
+    {
+        return std::abs(x) <= 0.5f ? 1.0f : 0.0f;
+    }
+
+    float triangle(float x)
+    {
+        x = std::abs(x);
+
+        return x < 1.0f ? 1.0f - x : 0.0f;
+    }
+
+    float catmull_rom(float x)
+    {
+        x = std::abs(x);
+
+        if (x < 1.0f)
+            return (1.5f * x - 2.5f) * x * x + 1.0f;
+
+        if (x < 2.0f)
+            return ((-0.5f * x + 2.5f) * x - 4.0f) * x + 2.0f;
+
+        return 0.0f;
+    }
+
+    float lanczos3(float x)
+    {
+        return std::abs(x) < 3.0f ? sinc(x) * sinc(x / 3.0f) : 0.0f;
+    }
+
+    float kaiser(float x)
+    {
+        constexpr float width { 3.0f }, alpha { 4.0f };
+
+        if (std::abs(x) >= width)
+            return 0.0f;
+
+        const float t { x / width };
+
+        return sinc(x) * bessel_i0(alpha * std::sqrt(1.0f - t * t)) / bessel_i0(alpha);
+    }
+
+    struct filter_info
+    {
+        float (*func)(float);
+
+        // The filter is zero beyond this distance, in source pixels when upscaling.
+        float support;
+    };
+
+    filter_info info_of(resample_filter rf)
+    {
+        switch (rf)
+        {
+        case resample_filter::box:
+            return { box, 0.5f };
+
+        case resample_filter::bicubic:
+            return { catmull_rom, 2.0f };
+
+        case resample_filter::lanczos3:
+            return { lanczos3, 3.0f };
+
+        case resample_filter::kaiser:
+            return { kaiser, 3.0f };
+
+        default:
+            return { triangle, 1.0f };
+        }
+    }
+
+    // Precomputed filter weights for one axis. Every output pixel is a weighted sum
+    // of `taps` consecutive input pixels, starting at `first`.
+    struct weight_table
+    {
+        weight_table(int src, int dst, filter_info fi)
+        {
+            const float scale { static_cast<float>(dst) / static_cast<float>(src) };
+
+            // When downscaling, the filter is stretched to cover every source pixel.
+            const float fscale { std::min(scale, 1.0f) };
+            const float support { fi.support / fscale };
+
+            taps = std::min(static_cast<int>(std::ceil(support * 2.0f)) + 1, src);
+
+            first.resize(static_cast<std::size_t>(dst));
+            weights.assign(static_cast<std::size_t>(dst) * taps, 0.0f);
+
+            for (int i { 0 }; i < dst; ++i)
+            {
+                const float center { (static_cast<float>(i) + 0.5f) / scale };
+
+                const int lo { std::max(static_cast<int>(std::floor(center - support)), 0) };
+                const int hi { std::min(static_cast<int>(std::ceil(center + support)), src) };
+
+                // Keep the window inside the source; the padding gets zero weights.
+                const int start { std::min(lo, src - taps) };
+
+                float* w { &weights[static_cast<std::size_t>(i) * taps] };
+                float  sum { 0.0f };
+
+                for (int j { lo }; j < hi; ++j)
+                {
+                    const float v { fi.func((static_cast<float>(j) + 0.5f - center) * fscale) };
+
+                    w[j - start] = v;
+                    sum += v;
+                }
+
+                // Taps outside of the source are dropped, so edges must be renormalized.
+                if (std::abs(sum) > 1e-6f)
+                {
+                    for (int k { 0 }; k < taps; ++k)
+                        w[k] /= sum;
+                }
+
+                else
+                    w[std::clamp(static_cast<int>(center), lo, hi - 1) - start] = 1.0f;
+
+                first[static_cast<std::size_t>(i)] = start;
+            }
+        }
+
+        std::vector<int>   first;
+        std::vector<float> weights;
+
+        int taps;
+    };
+
+    // ----- TRANSFER -----
+
+    // Conversion between bytes and the values color channels are filtered in.
+    struct transfer
+    {
+        constexpr static std::size_t encode_size { 16384 };
+
+        std::array<float, 256>                decode;
+        std::array<std::uint8_t, encode_size> encode;
+    };
+
+    float srgb_to_linear(float c)
+    {
+        return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+    }
+
+    float linear_to_srgb(float c)
+    {
+        return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+    }
+
+    transfer make_transfer(bool gamma_correct)
+    {
+        transfer ret;
+
+        for (std::size_t i { 0 }; i < ret.decode.size(); ++i)
+        {
+            const float c { static_cast<float>(i) / 255.0f };
+
+            ret.decode[i] = gamma_correct ? srgb_to_linear(c) : c;
+        }
+
+        for (std::size_t i { 0 }; i < transfer::encode_size; ++i)
+        {
+            const float c { static_cast<float>(i) / static_cast<float>(transfer::encode_size - 1) };
+
+            ret.encode[i] = static_cast<std::uint8_t>(std::clamp(gamma_correct ? linear_to_srgb(c) : c, 0.0f, 1.0f) * 255.0f + 0.5f);
+        }
+
+        return ret;
+    }
+
+    const transfer& transfer_of(bool gamma_correct)
+    {
+        static const transfer linear { make_transfer(false) }, srgb { make_transfer(true) };
+
+        return gamma_correct ? srgb : linear;
+    }
+
+    // RGBA32 bytes to premultiplied floats. Alpha is always linear.
+    void decode(const std::uint8_t* px, float* out, int n, const transfer& tf)
+    {
+        for (int i { 0 }; i < n; ++i, px += 4, out += 4)
+        {
+            const float a { static_cast<float>(px[3]) / 255.0f };
+
+            out[0] = tf.decode[px[0]] * a;
+            out[1] = tf.decode[px[1]] * a;
+            out[2] = tf.decode[px[2]] * a;
+            out[3] = a;
+        }
+    }
+
+    // Premultiplied floats back to RGBA32 bytes. Filters with negative lobes can
+    // overshoot, so everything is clamped.
+    void encode(const float* in, std::uint8_t* px, int n, const transfer& tf)
+    {
+        constexpr float max_index { static_cast<float>(transfer::encode_size - 1) };
+
+        for (int i { 0 }; i < n; ++i, in += 4, px += 4)
+        {
+            const float a { std::clamp(in[3], 0.0f, 1.0f) };
+
+            if (a <= 0.0f)
+            {
+                std::fill_n(px, 4, std::uint8_t { 0 });
+                continue;
+            }
+
+            for (int c { 0 }; c < 3; ++c)
+                px[c] = tf.encode[static_cast<std::size_t>(std::clamp(in[c] / a, 0.0f, 1.0f) * max_index + 0.5f)];
+
+            px[3] = static_cast<std::uint8_t>(a * 255.0f + 0.5f);
+        }
+    }
+
+    // ----- KERNELS -----
+
+    struct kernel_set
+    {
+        // Filter a row of pixels (four floats each) horizontally.
+        void (*horizontal)(const float* in, float* out, const weight_table& wt);
+
+        // out[i] += in[i] * w
+        void (*accumulate)(float* out, const float* in, std::size_t n, float w);
+    };
+
+    void horizontal_scalar(const float* in, float* out, const weight_table& wt)
+    {
+        for (std::size_t x { 0 }; x < wt.first.size(); ++x, out += 4)
+        {
+            const float* w { &wt.weights[x * wt.taps] };
+            const float* px { in + static_cast<std::size_t>(wt.first[x]) * 4 };
+
+            float acc[4] { 0.0f, 0.0f, 0.0f, 0.0f };
+
+            for (int k { 0 }; k < wt.taps; ++k, px += 4)
+                for (int c { 0 }; c < 4; ++c)
+                    acc[c] += w[k] * px[c];
+
+            std::copy_n(acc, 4, out);
+        }
+    }
+
+    void accumulate_scalar(float* out, const float* in, std::size_t n, float w)
+    {
+        for (std::size_t i { 0 }; i < n; ++i)
+            out[i] += in[i] * w;
+    }
+
+    constexpr kernel_set scalar_kernels {
+        horizontal_scalar,
+        accumulate_scalar
+    };
+
+#ifdef HAL_SIMD_X86
+    // A pixel fits exactly in an SSE register.
+    HAL_TARGET_SSE2 void horizontal_sse2(const float* in, float* out, const weight_table& wt)
+    {
+        for (std::size_t x { 0 }; x < wt.first.size(); ++x, out += 4)
+        {
+            const float* w { &wt.weights[x * wt.taps] };
+            const float* px { in + static_cast<std::size_t>(wt.first[x]) * 4 };
+
+            __m128 acc { _mm_setzero_ps() };
+
+            for (int k { 0 }; k < wt.taps; ++k, px += 4)
+                acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(px), _mm_set1_ps(w[k])));
+
+            _mm_storeu_ps(out, acc);
+        }
+    }
+
+    HAL_TARGET_SSE2 void accumulate_sse2(float* out, const float* in, std::size_t n, float w)
+    {
+        const __m128 wv { _mm_set1_ps(w) };
+
+        std::size_t i { 0 };
+
+        for (; i + 4 <= n; i += 4)
+            _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(_mm_loadu_ps(in + i), wv)));
+
+        accumulate_scalar(out + i, in + i, n - i, w);
+    }
+
+    constexpr kernel_set sse2_kernels {
+        horizontal_sse2,
+        accumulate_sse2
+    };
+
+    HAL_TARGET_AVX void accumulate_avx(float* out, const float* in, std::size_t n, float w)
+    {
+        const __m256 wv { _mm256_set1_ps(w) };
+
+        std::size_t i { 0 };
+
+        for (; i + 8 <= n; i += 8)
+            _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(out + i), _mm256_mul_ps(_mm256_loadu_ps(in + i), wv)));
+
+        accumulate_scalar(out + i, in + i, n - i, w);
+    }
+
+    // Horizontal taps are one pixel apart, so wider registers don't help there.
+    constexpr kernel_set avx_kernels {
+        horizontal_sse2,
+        accumulate_avx
+    };
+#endif
+
+    const kernel_set& select_kernels()
+    {
+#ifdef HAL_SIMD_X86
+        if (cpu::avx())
+            return avx_kernels;
+
+        if (cpu::sse2())
+            return sse2_kernels;
+#endif
+
+        return scalar_kernels;
+    }
+
+    // Chosen once, upon first use.
+    const kernel_set& kernels()
+    {
+        static const kernel_set& ks { select_kernels() };
+        return ks;
+    }
+}
+
+surface surface::resize(pixel::point sz, resample_filter rf, bool gamma_correct) const
+{
+    if (sz.x <= 0 || sz.y <= 0 || !valid())
+        return {};
+
+    // The filters work on RGBA32 bytes.
+    surface            converted;
+    const SDL_Surface* src { get() };
+
+    if (pixel_format() != pixel::format::rgba32 || must_lock())
+    {
+        converted = convert(pixel::format::rgba32);
+
+        if (!converted.valid())
+            return {};
+
+        src = converted.get();
+    }
+
+    surface ret { sz };
+
+    if (!ret.valid())
+        return ret;
+
+    const kernel_set&  ks { kernels() };
+    const transfer&    tf { transfer_of(gamma_correct) };
+    const filter_info  fi { info_of(rf) };
+    const weight_table horz { src->w, sz.x, fi }, vert { src->h, sz.y, fi };
+
+    const std::size_t out_floats { static_cast<std::size_t>(sz.x) * 4 };
+
+    // Only the source rows the vertical pass currently needs are kept, horizontally
+    // filtered, in a ring indexed by row modulo the amount of taps. Windows only ever
+    // move down, so each source row gets filtered at most once.
+    const std::size_t window { static_cast<std::size_t>(vert.taps) };
+
+    std::vector<float> row(static_cast<std::size_t>(src->w) * 4), out(out_floats);
+    std::vector<float> tmp(out_floats * window);
+
+    const auto filtered_row = [&](int y)
+    {
+        return tmp.data() + static_cast<std::size_t>(y) % window * out_floats;
+    };
+
+    int next { 0 };
+
+    for (int y { 0 }; y < sz.y; ++y)
+    {
+        const int first { vert.first[y] };
+
+        // Rows skipped entirely (i.e. by nearest filtering) aren't needed at all.
+        next = std::max(next, first);
+
+        for (; next < first + vert.taps; ++next)
+        {
+            decode(static_cast<const std::uint8_t*>(src->pixels) + static_cast<std::size_t>(next) * src->pitch, row.data(), src->w, tf);
+            ks.horizontal(row.data(), filtered_row(next), horz);
+        }
+
+        std::ranges::fill(out, 0.0f);
+
+        const float* w { &vert.weights[static_cast<std::size_t>(y) * vert.taps] };
+
+        for (int k { 0 }; k < vert.taps; ++k)
+        {
+            if (w[k] != 0.0f)
+                ks.accumulate(out.data(), filtered_row(first + k), out_floats, w[k]);
+        }
+
+        encode(out.data(), static_cast<std::uint8_t*>(ret->pixels) + static_cast<std::size_t>(y) * ret->pitch, sz.x, tf);
+    }
+
+    return ret;
+}
+
+std::vector<surface> surface::build_mips(resample_filter rf, bool gamma_correct) const
+{
+    std::vector<surface> ret;
+
+    if (!valid())
+        return ret;
+
+    pixel::point sz { size() };
+
+    // Every level is made from the previous one, which is much cheaper than
+    // filtering the full-size image each time.
+    while (sz.x > 1 || sz.y > 1)
+    {
+        sz = { std::max(sz.x / 2, 1), std::max(sz.y / 2, 1) };
+
+        surface level { (ret.empty() ? *this : ret.back()).resize(sz, rf, gamma_correct) };
+
+        if (!level.valid())
+            break;
+
+        ret.push_back(std::move(level));
+    }
+
+    return ret;
+}
@@ -1,16 +1,121 @@
 #include <halcyon/surface.hpp>
 
+#include <halcyon/internal/convert.hpp>
 #include <halcyon/utility/guard.hpp>
+#include <halcyon/utility/thread_pool.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
 
 using namespace hal;
 
 namespace
 {
+    // Bands shorter than this aren't worth handing to another thread.
+    constexpr int min_band_rows { 64 };
+
     SDL_Surface* copy_from(ref<const surface> s)
     {
         const SDL_Surface& ref { *s->get() };
         return ::SDL_CreateSurfaceFrom(ref.w, ref.h, ref.format, ref.pixels, ref.pitch);
     }
+
+    // A surface sharing some rows of another's pixels, with the same blitting attributes.
+    // Blitting modifies the source and destination (i.e. their blit maps), so every
+    // thread needs its own pair of surfaces.
+    SDL_Surface* view_of(SDL_Surface* s, int first_row, int rows)
+    {
+        SDL_Surface* ret { ::SDL_CreateSurfaceFrom(s->w, rows, s->format, static_cast<Uint8*>(s->pixels) + first_row * s->pitch, s->pitch) };
+
+        if (ret == nullptr)
+            return nullptr;
+
+        SDL_BlendMode bm;
+        Uint8         r, g, b, a;
+        Uint32        key;
+
+        if (SDL_Palette* p { ::SDL_GetSurfacePalette(s) }; p != nullptr)
+            ::SDL_SetSurfacePalette(ret, p);
+
+        if (::SDL_GetSurfaceBlendMode(s, &bm))
+            ::SDL_SetSurfaceBlendMode(ret, bm);
+
+        if (::SDL_GetSurfaceColorMod(s, &r, &g, &b))
+            ::SDL_SetSurfaceColorMod(ret, r, g, b);
+
+        if (::SDL_GetSurfaceAlphaMod(s, &a))
+            ::SDL_SetSurfaceAlphaMod(ret, a);
+
+        if (::SDL_SurfaceHasColorKey(s) && ::SDL_GetSurfaceColorKey(s, &key))
+            ::SDL_SetSurfaceColorKey(ret, true, key);
+
+        ::SDL_SetSurfaceColorspace(ret, ::SDL_GetSurfaceColorspace(s));
+
+        return ret;
+    }
+
+    // Perform a blit in horizontal bands of the destination, using a thread pool.
+    // `dst_rect` must be the full destination area, including its size.
+    template <typename F>
+    bool blit_banded(SDL_Surface* src, const SDL_Rect* src_rect, SDL_Surface* dst, SDL_Rect dst_rect, thread_pool& pool, F&& func)
+    {
+        SDL_Rect clip;
+        ::SDL_GetSurfaceClipRect(dst, &clip);
+
+        const int first { std::max(clip.y, dst_rect.y) };
+        const int rows { std::min(clip.y + clip.h, dst_rect.y + dst_rect.h) - first };
+
+        const int bands { std::min(static_cast<int>(pool.size()) + 1, rows / min_band_rows) };
+
+        // RLE-encoded surfaces' pixels can't be shared.
+        if (bands < 2 || SDL_MUSTLOCK(src) || SDL_MUSTLOCK(dst))
+            return func(src, src_rect, dst, &dst_rect);
+
+        // Views are made and destroyed on this thread only, since attaching a palette
+        // changes its reference count, which isn't atomic.
+        std::vector<SDL_Surface*> src_views(static_cast<std::size_t>(bands)), dst_views(static_cast<std::size_t>(bands));
+
+        bool ret { true };
+
+        for (int i { 0 }; i < bands; ++i)
+        {
+            const int begin { first + rows * i / bands };
+            const int end { first + rows * (i + 1) / bands };
+
+            src_views[i] = view_of(src, 0, src->h);
+            dst_views[i] = view_of(dst, begin, end - begin);
+
+            if (src_views[i] == nullptr || dst_views[i] == nullptr)
+                ret = false;
+        }
+
+        std::atomic<bool> blitted { true };
+
+        if (ret)
+            pool.for_each(static_cast<std::size_t>(bands), [&](std::size_t i)
+                {
+                    const int begin { first + rows * static_cast<int>(i) / bands };
+                    const int end { first + rows * (static_cast<int>(i) + 1) / bands };
+
+                    // The whole destination area, shifted so that only this band is visible.
+                    const SDL_Rect band_clip { clip.x, 0, clip.w, end - begin };
+                    const SDL_Rect band_rect { dst_rect.x, dst_rect.y - begin, dst_rect.w, dst_rect.h };
+
+                    ::SDL_SetSurfaceClipRect(dst_views[i], &band_clip);
+
+                    if (!func(src_views[i], src_rect, dst_views[i], &band_rect))
+                        blitted = false;
+                });
+
+        for (int i { 0 }; i < bands; ++i)
+        {
+            ::SDL_DestroySurface(src_views[i]);
+            ::SDL_DestroySurface(dst_views[i]);
+        }
+
+        return ret && blitted;
+    }
 }
 
 surface::surface(pointer ptr)
@@ -77,7 +182,38 @@ blitter surface::blit(ref<surface> dst) const
 
 surface surface::convert(pixel::format fmt) const
 {
-    return ::SDL_ConvertSurface(get(), static_cast<SDL_PixelFormat>(fmt));
+    SDL_Surface* const src { get() };
+
+    // Common conversions of plain pixels skip SDL's generic blitters; anything
+    // involving color keys, RLE or other color spaces is left to SDL.
+    if (const detail::convert_func func { detail::find_convert(pixel_format(), fmt) };
+        func != nullptr && !SDL_MUSTLOCK(src) && !::SDL_SurfaceHasColorKey(src) && ::SDL_GetSurfaceColorspace(src) == SDL_COLORSPACE_SRGB)
+    {
+        surface ret { size(), fmt };
+
+        if (ret.valid() && func(*src, *ret.get()))
+        {
+            Uint8         r, g, b, a;
+            SDL_BlendMode bm { SDL_BLENDMODE_NONE };
+
+            ::SDL_GetSurfaceColorMod(src, &r, &g, &b);
+            ::SDL_GetSurfaceAlphaMod(src, &a);
+            ::SDL_GetSurfaceBlendMode(src, &bm);
+
+            ::SDL_SetSurfaceColorMod(ret.get(), r, g, b);
+            ::SDL_SetSurfaceAlphaMod(ret.get(), a);
+
+            // Same as SDL: blend if there's any alpha to blend with.
+            if ((SDL_ISPIXELFORMAT_ALPHA(src->format) && SDL_ISPIXELFORMAT_ALPHA(ret.get()->format)) || a != 0xFF)
+                bm = SDL_BLENDMODE_BLEND;
+
+            ::SDL_SetSurfaceBlendMode(ret.get(), bm);
+
+            return ret;
+        }
+    }
+
+    return ::SDL_ConvertSurface(src, static_cast<SDL_PixelFormat>(fmt));
 }
 
 pixel::point surface::size() const
@@ -102,6 +238,15 @@ surface surface::resize(pixel::point sz, scale_mode sm) const
     return ret;
 }
 
+surface surface::resize(pixel::point sz, scale_mode sm, thread_pool& pool) const
+{
+    surface ret { sz };
+
+    blit(ret).to(tag::fill).scaled(sm, pool);
+
+    return ret;
+}
+
 bool surface::must_lock() const
 {
     return SDL_MUSTLOCK(get());
@@ -178,6 +323,9 @@ Uint32 surface::map_rgba(color c) const
 
 bool blitter::blit() const
 {
+    if (culled(m_posDst))
+        return true;
+
     return ::SDL_BlitSurface(
         m_drawSrc.get(),
         m_posSrc.pos.x == unset_pos() ? nullptr : m_posSrc.sdl_ptr(),
@@ -187,6 +335,9 @@ bool blitter::blit() const
 
 bool blitter::scaled(scale_mode sm) const
 {
+    if (culled(m_posDst))
+        return true;
+
     return ::SDL_BlitSurfaceScaled(
         m_drawSrc.get(),
         m_posSrc.pos.x == unset_pos() ? nullptr : m_posSrc.sdl_ptr(),
@@ -195,8 +346,43 @@ bool blitter::scaled(scale_mode sm) const
         static_cast<SDL_ScaleMode>(sm));
 }
 
+bool blitter::blit(thread_pool& pool) const
+{
+    if (culled(m_posDst))
+        return true;
+
+    const bool has_src { m_posSrc.pos.x != unset_pos() };
+
+    // Only the position is used; the size is that of the source area.
+    const SDL_Rect dst_rect {
+        m_posDst.pos.x == unset_pos() ? 0 : m_posDst.pos.x,
+        m_posDst.pos.x == unset_pos() ? 0 : m_posDst.pos.y,
+        has_src ? m_posSrc.size.x : m_drawSrc->get()->w,
+        has_src ? m_posSrc.size.y : m_drawSrc->get()->h
+    };
+
+    return blit_banded(m_drawSrc.get(), has_src ? m_posSrc.sdl_ptr() : nullptr, m_drawDst.get(), dst_rect, pool,
+        [](SDL_Surface* src, const SDL_Rect* src_rect, SDL_Surface* dst, const SDL_Rect* dst_rect)
+        { return ::SDL_BlitSurface(src, src_rect, dst, dst_rect); });
+}
+
+bool blitter::scaled(scale_mode sm, thread_pool& pool) const
+{
+    if (culled(m_posDst))
+        return true;
+
+    const SDL_Rect dst_rect { m_posDst.pos.x == unset_pos() ? SDL_Rect { 0, 0, m_drawDst->get()->w, m_drawDst->get()->h } : *m_posDst.sdl_ptr() };
+
+    return blit_banded(m_drawSrc.get(), m_posSrc.pos.x == unset_pos() ? nullptr : m_posSrc.sdl_ptr(), m_drawDst.get(), dst_rect, pool,
+        [sm](SDL_Surface* src, const SDL_Rect* src_rect, SDL_Surface* dst, const SDL_Rect* dst_rect)
+        { return ::SDL_BlitSurfaceScaled(src, src_rect, dst, dst_rect, static_cast<SDL_ScaleMode>(sm)); });
+}
+
 bool blitter::tiled() const
 {
+    if (culled(m_posDst))
+        return true;
+
     return ::SDL_BlitSurfaceTiled(
         m_drawSrc.get(),
         m_posSrc.pos.x == unset_pos() ? nullptr : m_posSrc.sdl_ptr(),
@@ -206,6 +392,9 @@ bool blitter::tiled() const
 
 bool blitter::tiled_scale(float scale, scale_mode sm) const
 {
+    if (culled(m_posDst))
+        return true;
+
     return ::SDL_BlitSurfaceTiledWithScale(
         m_drawSrc.get(),
         m_posSrc.pos.x == unset_pos() ? nullptr : m_posSrc.sdl_ptr(),
@@ -217,6 +406,9 @@ bool blitter::tiled_scale(float scale, scale_mode sm) const
 
 bool blitter::nine_grid(pixel_t width_left, pixel_t width_right, pixel_t height_top, pixel_t height_bottom, float scale, scale_mode sm) const
 {
+    if (culled(m_posDst))
+        return true;
+
     return ::SDL_BlitSurface9Grid(
         m_drawSrc.get(),
         m_posSrc.pos.x == unset_pos() ? nullptr : m_posSrc.sdl_ptr(),
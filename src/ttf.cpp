@@ -1,12 +1,59 @@
 #include <halcyon/ttf.hpp>
 
 #include <halcyon/types/exception.hpp>
+#include <halcyon/utility/guard.hpp>
+#include <halcyon/utility/thread_pool.hpp>
 #include <halcyon/video/renderer.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <string_view>
 
 using namespace hal;
 
+namespace
+{
+    // Name of the property that ties a font face's data to a stream reading from it.
+    constexpr char face_property[] { "halcyon.font_face" };
+
+    void release_face(void*, void* data)
+    {
+        delete static_cast<std::shared_ptr<const std::byte>*>(data);
+    }
+
+    // Resolved scales are cached in steps of this fraction.
+    constexpr int sdf_scale_steps { 64 };
+
+    // Cached textures are allocated in steps of this many pixels.
+    constexpr pixel_t sdf_texture_step { 32 };
+
+    pixel_t round_up(pixel_t size)
+    {
+        return (size + sdf_texture_step - 1) / sdf_texture_step * sdf_texture_step;
+    }
+
+    float saturate(float x)
+    {
+        return std::clamp(x, 0.0f, 1.0f);
+    }
+
+    // Straight-alpha "over" compositing, with coverage in [0, 1].
+    struct layer
+    {
+        float r, g, b, a;
+
+        void under(color c, float coverage)
+        {
+            const float ca { c.a / 255.0f * coverage * (1.0f - a) };
+
+            r += c.r * ca;
+            g += c.g * ca;
+            b += c.b * ca;
+            a += ca;
+        }
+    };
+}
+
 text::text(hal::ref<const font> f, std::string_view str)
     : text { nullptr, f, str }
 {
@@ -24,11 +71,65 @@ result<pixel::point> text::size() const
     return { ::TTF_GetTextSize(get(), &ret.x, &ret.y), ret };
 }
 
+std::string_view text::str() const
+{
+    return get()->text != nullptr ? get()->text : std::string_view {};
+}
+
+bool text::set(std::string_view str)
+{
+    return ::TTF_SetTextString(get(), str.data(), str.length());
+}
+
+bool text::append(std::string_view str)
+{
+    return ::TTF_AppendTextString(get(), str.data(), str.length());
+}
+
+bool text::insert(int offset, std::string_view str)
+{
+    return ::TTF_InsertTextString(get(), offset, str.data(), str.length());
+}
+
+bool text::erase(int offset, int length)
+{
+    return ::TTF_DeleteTextString(get(), offset, length);
+}
+
+result<color> text::color() const
+{
+    hal::color ret;
+
+    return { ::TTF_GetTextColor(get(), &ret.r, &ret.g, &ret.b, &ret.a), ret };
+}
+
+bool text::color(hal::color c)
+{
+    return ::TTF_SetTextColor(get(), c.r, c.g, c.b, c.a);
+}
+
+result<pixel_t> text::wrap_width() const
+{
+    int ret { 0 };
+
+    return { ::TTF_GetTextWrapWidth(get(), &ret), static_cast<pixel_t>(ret) };
+}
+
+bool text::wrap_width(pixel_t width)
+{
+    return ::TTF_SetTextWrapWidth(get(), width);
+}
+
 font::font(accessor src, pt_t size, pass_key<ttf::context>)
     : resource { ::TTF_OpenFontIO(src.release(), true, size) }
 {
 }
 
+font::font(const font_face& face, pt_t size, pass_key<ttf::context>)
+    : resource { ::TTF_OpenFontIO(face.open(), true, size) }
+{
+}
+
 surface font::render_solid(std::string_view text, color fg) const
 {
     return ::TTF_RenderText_Solid(get(), text.data(), text.length(), fg);
@@ -89,6 +190,46 @@ surface font::render_lcd(char32_t glyph, color fg, color bg) const
     return ::TTF_RenderGlyph_LCD(get(), glyph, fg, bg);
 }
 
+bool font::size(pt_t size)
+{
+    return ::TTF_SetFontSize(get(), size);
+}
+
+font::pt_t font::size() const
+{
+    return static_cast<pt_t>(std::lround(::TTF_GetFontSize(get())));
+}
+
+bool font::sdf(bool enable)
+{
+    return ::TTF_SetFontSDF(get(), enable);
+}
+
+bool font::sdf() const
+{
+    return ::TTF_GetFontSDF(get());
+}
+
+std::size_t font::warm_up(std::u32string_view glyphs) const
+{
+    std::size_t ret { 0 };
+
+    for (const char32_t ch : glyphs)
+    {
+        if (!::TTF_FontHasGlyph(get(), ch))
+            continue;
+
+        // The surface itself is thrown away; the font keeps the rasterized glyph.
+        if (::SDL_Surface* surf { ::TTF_RenderGlyph_Blended(get(), ch, color { colors::white }) }; surf != nullptr)
+        {
+            ::SDL_DestroySurface(surf);
+            ++ret;
+        }
+    }
+
+    return ret;
+}
+
 pixel_t font::height() const
 {
     return static_cast<pixel_t>(::TTF_GetFontHeight(get()));
@@ -114,6 +255,298 @@ bool font::mono() const
     return ::TTF_FontIsFixedWidth(get());
 }
 
+// ----- Font faces -----
+
+font_face::font_face(accessor src)
+{
+    std::size_t size { 0 };
+
+    // SDL_ttf reads fonts lazily, so the whole file is loaded up front to be shared.
+    if (void* data { ::SDL_LoadFile_IO(src.get(), &size, false) }; data != nullptr)
+    {
+        m_data.reset(static_cast<const std::byte*>(data), [](const std::byte* ptr)
+            { ::SDL_free(const_cast<std::byte*>(ptr)); });
+
+        m_size = size;
+    }
+
+    else
+        HAL_WARN("Could not load font face: ", debug::last_error());
+}
+
+std::size_t font_face::size() const
+{
+    return m_size;
+}
+
+bool font_face::valid() const
+{
+    return m_data != nullptr;
+}
+
+SDL_IOStream* font_face::open() const
+{
+    HAL_ASSERT(valid(), "Opening an invalid font face");
+
+    SDL_IOStream* ret { ::SDL_IOFromConstMem(m_data.get(), m_size) };
+
+    // The stream's properties are destroyed when it's closed, along with this reference.
+    if (ret != nullptr && !::SDL_SetPointerPropertyWithCleanup(::SDL_GetIOProperties(ret), face_property, new std::shared_ptr<const std::byte> { m_data }, release_face, nullptr))
+    {
+        ::SDL_CloseIO(ret);
+        return nullptr;
+    }
+
+    return ret;
+}
+
+// ----- SDF text -----
+
+sdf_text::sdf_text(ref<const font> f, std::string_view text)
+    : sdf_text { f, text, style {} }
+{
+}
+
+sdf_text::sdf_text(ref<const font> f, std::string_view text, const style& st, std::size_t max_cached)
+    : m_style { st }
+    , m_maxCached { std::max<std::size_t>(max_cached, 1) }
+{
+    HAL_ASSERT(f->sdf(), "Font must have SDF enabled");
+
+    const surface rendered { f->render_blended(text, colors::white) };
+
+    if (!rendered.valid())
+        return;
+
+    const surface field { rendered.convert(pixel::format::rgba32) };
+
+    if (!field.valid())
+        return;
+
+    const SDL_Surface& fs { *field };
+
+    m_size = field.size();
+    m_field.resize(std::size_t(m_size.x) * m_size.y);
+
+    for (pixel_t y { 0 }; y < m_size.y; ++y)
+        for (pixel_t x { 0 }; x < m_size.x; ++x)
+            m_field[std::size_t(y) * m_size.x + x] = static_cast<const std::uint8_t*>(fs.pixels)[y * fs.pitch + x * 4 + 3];
+}
+
+bool sdf_text::render(lref<renderer> rnd, coord::point pos, float scale)
+{
+    if (!valid() || scale <= 0.0f)
+        return false;
+
+    // Textures can't be drawn with any renderer but their own.
+    if (rnd.get() != m_renderer)
+    {
+        m_cache.clear();
+        m_renderer = rnd.get();
+    }
+
+    const int key { static_cast<int>(std::lround(scale * sdf_scale_steps)) };
+
+    auto iter = std::ranges::find(m_cache, key, &cache_slot::key);
+
+    if (iter != m_cache.end())
+        std::rotate(m_cache.begin(), iter, iter + 1);
+
+    else
+    {
+        // Reuse the least recently used slot, so that animating the scale doesn't
+        // create (and destroy) a texture every frame.
+        if (m_cache.size() < m_maxCached)
+            m_cache.insert(m_cache.begin(), { key, { 0, 0 }, {} });
+
+        else
+            std::rotate(m_cache.begin(), m_cache.end() - 1, m_cache.end());
+
+        cache_slot&        slot { m_cache.front() };
+        const float        resolved { static_cast<float>(key) / sdf_scale_steps };
+        const pixel::point sz { size(resolved) };
+
+        if (sz.x <= 0 || sz.y <= 0)
+        {
+            m_cache.erase(m_cache.begin());
+            return false;
+        }
+
+        // One more row and column are cleared, since filtering can sample them.
+        const pixel::point area { sz.x + 1, sz.y + 1 };
+        const pixel::point cap { slot.tex.valid() ? slot.tex.size().get_or({}) : pixel::point { 0, 0 } };
+
+        if (cap.x < area.x || cap.y < area.y)
+        {
+            // Growing in steps keeps a slowly growing scale from reallocating every frame.
+            const pixel::point grown { round_up(std::max(cap.x, area.x)), round_up(std::max(cap.y, area.y)) };
+
+            slot.tex = { rnd, grown, pixel::format::rgba32 };
+
+            if (!slot.tex.valid() || !slot.tex.blend(blend_mode::alpha))
+            {
+                m_cache.erase(m_cache.begin());
+                return false;
+            }
+        }
+
+        slot.size = sz;
+
+        {
+            const pixel::point tex_size { slot.tex.size().get_or({}) };
+            const pixel::point locked { std::min(area.x, tex_size.x), std::min(area.y, tex_size.y) };
+
+            guard::lock lock { slot.tex, { 0, 0, locked.x, locked.y } };
+
+            if (!lock.res.valid())
+            {
+                m_cache.erase(m_cache.begin());
+                return false;
+            }
+
+            const lock_data ld { lock.res.get() };
+
+            resolve(resolved, ld.pixels, ld.pitch);
+
+            for (pixel_t y { 0 }; y < locked.y; ++y)
+            {
+                std::byte* row { ld.pixels + std::ptrdiff_t(y) * ld.pitch };
+
+                if (y >= sz.y)
+                    std::fill_n(row, std::size_t(locked.x) * 4, std::byte {});
+
+                else if (locked.x > sz.x)
+                    std::fill_n(row + std::size_t(sz.x) * 4, std::size_t(locked.x - sz.x) * 4, std::byte {});
+            }
+        }
+
+        slot.key = key;
+    }
+
+    // Shadows cast up or left extend the text's area before its origin.
+    const coord::point origin {
+        std::min(m_style.shadow_offset.x, 0.0f) * scale,
+        std::min(m_style.shadow_offset.y, 0.0f) * scale
+    };
+
+    const cache_slot& slot { m_cache.front() };
+
+    return rnd->draw(slot.tex).from({ 0, 0, slot.size.x, slot.size.y }).to(pos + origin).render();
+}
+
+surface sdf_text::resolve(float scale) const
+{
+    if (!valid() || scale <= 0.0f)
+        return {};
+
+    surface ret { size(scale), pixel::format::rgba32 };
+
+    if (!ret.valid())
+        return ret;
+
+    SDL_Surface& rs { *ret };
+
+    resolve(scale, static_cast<std::byte*>(rs.pixels), rs.pitch);
+
+    return ret;
+}
+
+void sdf_text::resolve(float scale, std::byte* pixels, int pitch) const
+{
+    const style& st { m_style };
+
+    const coord::point off { st.shadow_offset };
+    const coord::point origin { std::min(off.x, 0.0f), std::min(off.y, 0.0f) };
+
+    const pixel::point sz { size(scale) };
+
+    const bool has_outline { st.outline.a != 0 && st.outline_width > 0.0f };
+    const bool has_shadow { st.shadow.a != 0 };
+
+    // Softness is spread over at least a pixel of the output, so shadows never alias.
+    const float shadow_edge { std::max(st.shadow_softness * scale, 1.0f) };
+
+    for (int y { 0 }; y < sz.y; ++y)
+    {
+        std::uint8_t* row { reinterpret_cast<std::uint8_t*>(pixels) + y * pitch };
+
+        for (int x { 0 }; x < sz.x; ++x)
+        {
+            // Sample at pixel centers, in the field's own pixels.
+            const coord::point pos {
+                origin.x + (static_cast<float>(x) + 0.5f) / scale - 0.5f,
+                origin.y + (static_cast<float>(y) + 0.5f) / scale - 0.5f
+            };
+
+            // Distances are scaled to the output, so edges stay a single pixel wide.
+            const float dist { distance(pos) * scale };
+
+            layer px { 0.0f, 0.0f, 0.0f, 0.0f };
+
+            px.under(st.fill, saturate(dist + 0.5f));
+
+            if (has_outline)
+                px.under(st.outline, saturate(dist + st.outline_width * scale + 0.5f));
+
+            if (has_shadow)
+                px.under(st.shadow, saturate(distance({ pos.x - off.x, pos.y - off.y }) * scale / shadow_edge + 0.5f));
+
+            std::uint8_t* out { row + x * 4 };
+
+            if (px.a > 0.0f)
+            {
+                out[0] = static_cast<std::uint8_t>(px.r / px.a + 0.5f);
+                out[1] = static_cast<std::uint8_t>(px.g / px.a + 0.5f);
+                out[2] = static_cast<std::uint8_t>(px.b / px.a + 0.5f);
+            }
+
+            else
+                out[0] = out[1] = out[2] = 0;
+
+            out[3] = static_cast<std::uint8_t>(px.a * 255.0f + 0.5f);
+        }
+    }
+}
+
+pixel::point sdf_text::size(float scale) const
+{
+    const coord::point off { m_style.shadow_offset };
+
+    return {
+        static_cast<pixel_t>(std::ceil((static_cast<float>(m_size.x) + std::abs(off.x)) * scale)),
+        static_cast<pixel_t>(std::ceil((static_cast<float>(m_size.y) + std::abs(off.y)) * scale))
+    };
+}
+
+bool sdf_text::valid() const
+{
+    return !m_field.empty();
+}
+
+float sdf_text::distance(coord::point pos) const
+{
+    // Bilinear filtering keeps distances (unlike coverage) accurate between pixels.
+    const int   x0 { static_cast<int>(std::floor(pos.x)) }, y0 { static_cast<int>(std::floor(pos.y)) };
+    const float fx { pos.x - static_cast<float>(x0) }, fy { pos.y - static_cast<float>(y0) };
+
+    // Anything outside of the field is as far away as can be stored.
+    const auto at = [this](int x, int y) -> float
+    {
+        if (x < 0 || y < 0 || x >= m_size.x || y >= m_size.y)
+            return 0.0f;
+
+        return m_field[std::size_t(y) * m_size.x + x];
+    };
+
+    const float top { at(x0, y0) + (at(x0 + 1, y0) - at(x0, y0)) * fx };
+    const float bottom { at(x0, y0 + 1) + (at(x0 + 1, y0 + 1) - at(x0, y0 + 1)) * fx };
+
+    // 128 is the outline; values above it are inside the glyph.
+    return (top + (bottom - top) * fy - 128.0f) / 128.0f * spread;
+}
+
+// ----- TTF context -----
+
 ttf::context::context()
 {
     HAL_WARN_IF(initialized(), "TTF context already exists");
@@ -141,13 +574,112 @@ font ttf::context::make_font(accessor data, font::pt_t size) const
     return { std::move(data), size, pass_key<context> {} };
 }
 
+font ttf::context::make_font(const font_face& face, font::pt_t size) const
+{
+    return { face, size, pass_key<context> {} };
+}
+
 bool ttf::initialized()
 {
     return ::TTF_WasInit() != 0;
 }
 
+std::vector<std::future<std::size_t>> ttf::warm_up(std::span<const ref<const font>> fonts, std::u32string_view glyphs, thread_pool& pool)
+{
+    // Tasks may outlive the caller's string.
+    const auto shared = std::make_shared<const std::u32string>(glyphs);
+
+    std::vector<std::future<std::size_t>> ret;
+    ret.reserve(fonts.size());
+
+    for (const ref<const font>& f : fonts)
+        ret.push_back(pool.submit([f, shared]
+            { return f->warm_up(*shared); }));
+
+    return ret;
+}
+
+std::u32string ttf::charset::ascii()
+{
+    std::u32string ret;
+
+    for (char32_t ch { 0x20 }; ch < 0x7F; ++ch)
+        ret += ch;
+
+    return ret;
+}
+
+std::u32string ttf::charset::latin1()
+{
+    std::u32string ret { ascii() };
+
+    for (char32_t ch { 0xA0 }; ch <= 0xFF; ++ch)
+        ret += ch;
+
+    return ret;
+}
+
+std::u32string ttf::charset::from(std::span<const std::string_view> strings)
+{
+    std::u32string ret;
+
+    for (const std::string_view str : strings)
+    {
+        const char* ptr { str.data() };
+        std::size_t len { str.size() };
+
+        // SDL stops at embedded null characters.
+        while (len > 0)
+        {
+            const Uint32 ch { ::SDL_StepUTF8(&ptr, &len) };
+
+            if (ch == 0)
+                break;
+
+            ret += static_cast<char32_t>(ch);
+        }
+    }
+
+    std::ranges::sort(ret);
+    ret.erase(std::ranges::unique(ret).begin(), ret.end());
+
+    return ret;
+}
+
 // ----- Text engines -----
 
+std::size_t detail::warm_up_engine(TTF_TextEngine* eng, ref<const font> f, std::u32string_view glyphs)
+{
+    std::string str;
+    std::size_t ret { 0 };
+
+    for (const char32_t ch : glyphs)
+    {
+        if (!::TTF_FontHasGlyph(f.get(), ch))
+            continue;
+
+        char buf[4];
+        str.append(buf, ::SDL_UCS4ToUTF8(ch, buf));
+
+        ++ret;
+    }
+
+    if (str.empty())
+        return 0;
+
+    // Engines rasterize glyphs into their atlas when text is laid out, and keep them
+    // cached per font afterwards, so the text itself can be thrown away.
+    ::TTF_Text* txt { ::TTF_CreateText(eng, f.get(), str.data(), str.size()) };
+
+    if (txt == nullptr)
+        return 0;
+
+    const bool laid_out { ::TTF_UpdateText(txt) };
+    ::TTF_DestroyText(txt);
+
+    return laid_out ? ret : 0;
+}
+
 text_engine::surface::surface()
     : engine_base { ::TTF_CreateSurfaceTextEngine() }
 {
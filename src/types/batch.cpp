@@ -0,0 +1,451 @@
+#include <halcyon/types/batch.hpp>
+
+#include <halcyon/debug.hpp>
+#include <halcyon/internal/simd.hpp>
+#include <halcyon/system.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace hal;
+
+// The kernels work on the underlying floats.
+static_assert(std::is_same_v<coord_t, float>);
+static_assert(sizeof(coord::point) == 2 * sizeof(float) && sizeof(coord::rect) == 4 * sizeof(float));
+
+namespace
+{
+    // Kernel signatures. Counts are in floats for `mul_add`, otherwise in elements.
+    struct kernel_set
+    {
+        batch::isa set;
+
+        // d[i] = d[i] * mul[i % 4] + add[i % 4]
+        void (*mul_add)(float* d, std::size_t n, const float* mul, const float* add);
+
+        // pos += size * k
+        void (*anchor)(float* d, std::size_t n, float kx, float ky);
+
+        void (*affine_points)(float* d, std::size_t n, const batch::matrix& m);
+        void (*affine_rects)(float* d, std::size_t n, const batch::matrix& m);
+
+        std::size_t (*intersect)(const float* d, std::size_t n, const coord::rect& area, bool* out);
+    };
+
+    // ----- SCALAR -----
+
+    void mul_add_scalar(float* d, std::size_t n, const float* mul, const float* add)
+    {
+        for (std::size_t i { 0 }; i < n; ++i)
+            d[i] = d[i] * mul[i % 4] + add[i % 4];
+    }
+
+    void anchor_scalar(float* d, std::size_t n, float kx, float ky)
+    {
+        for (std::size_t i { 0 }; i < n; ++i, d += 4)
+        {
+            d[0] += d[2] * kx;
+            d[1] += d[3] * ky;
+        }
+    }
+
+    void affine_points_scalar(float* d, std::size_t n, const batch::matrix& m)
+    {
+        for (std::size_t i { 0 }; i < n; ++i, d += 2)
+        {
+            const float x { d[0] }, y { d[1] };
+
+            d[0] = x * m.xx + y * m.yx + m.tx;
+            d[1] = x * m.xy + y * m.yy + m.ty;
+        }
+    }
+
+    void affine_rects_scalar(float* d, std::size_t n, const batch::matrix& m)
+    {
+        for (std::size_t i { 0 }; i < n; ++i, d += 4)
+        {
+            const float x { d[0] }, y { d[1] }, w { d[2] }, h { d[3] };
+
+            // The minimum corner gets pushed back by every negative axis contribution.
+            d[0] = x * m.xx + y * m.yx + m.tx + (std::min(w * m.xx, 0.0f) + std::min(h * m.yx, 0.0f));
+            d[1] = x * m.xy + y * m.yy + m.ty + (std::min(w * m.xy, 0.0f) + std::min(h * m.yy, 0.0f));
+            d[2] = w * std::abs(m.xx) + h * std::abs(m.yx);
+            d[3] = w * std::abs(m.xy) + h * std::abs(m.yy);
+        }
+    }
+
+    std::size_t intersect_scalar(const float* d, std::size_t n, const coord::rect& area, bool* out)
+    {
+        std::size_t ret { 0 };
+
+        for (std::size_t i { 0 }; i < n; ++i, d += 4)
+        {
+            const coord::rect r { d[0], d[1], d[2], d[3] };
+
+            out[i] = r | area;
+            ret += out[i];
+        }
+
+        return ret;
+    }
+
+    constexpr kernel_set scalar_kernels {
+        batch::isa::scalar,
+        mul_add_scalar,
+        anchor_scalar,
+        affine_points_scalar,
+        affine_rects_scalar,
+        intersect_scalar
+    };
+
+#ifdef HAL_SIMD_X86
+    // ----- SSE2 -----
+
+    HAL_TARGET_SSE2 void mul_add_sse2(float* d, std::size_t n, const float* mul, const float* add)
+    {
+        const __m128 vm { _mm_loadu_ps(mul) }, va { _mm_loadu_ps(add) };
+
+        std::size_t i { 0 };
+
+        for (; i + 4 <= n; i += 4)
+            _mm_storeu_ps(d + i, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(d + i), vm), va));
+
+        // Since `i` is a multiple of 4, the pattern stays aligned.
+        mul_add_scalar(d + i, n - i, mul, add);
+    }
+
+    HAL_TARGET_SSE2 void anchor_sse2(float* d, std::size_t n, float kx, float ky)
+    {
+        const __m128 k { _mm_setr_ps(kx, ky, 0.0f, 0.0f) };
+
+        for (std::size_t i { 0 }; i < n; ++i, d += 4)
+        {
+            const __m128 v { _mm_loadu_ps(d) };
+            const __m128 size { _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 2, 3, 2)) };
+
+            _mm_storeu_ps(d, _mm_add_ps(v, _mm_mul_ps(size, k)));
+        }
+    }
+
+    HAL_TARGET_SSE2 void affine_points_sse2(float* d, std::size_t n, const batch::matrix& m)
+    {
+        const __m128 cx { _mm_setr_ps(m.xx, m.xy, m.xx, m.xy) };
+        const __m128 cy { _mm_setr_ps(m.yx, m.yy, m.yx, m.yy) };
+        const __m128 t { _mm_setr_ps(m.tx, m.ty, m.tx, m.ty) };
+
+        std::size_t i { 0 };
+
+        // Two points at a time.
+        for (; i + 2 <= n; i += 2, d += 4)
+        {
+            const __m128 v { _mm_loadu_ps(d) };
+            const __m128 xs { _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 0, 0)) };
+            const __m128 ys { _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 1, 1)) };
+
+            _mm_storeu_ps(d, _mm_add_ps(_mm_add_ps(_mm_mul_ps(xs, cx), _mm_mul_ps(ys, cy)), t));
+        }
+
+        affine_points_scalar(d, n - i, m);
+    }
+
+    HAL_TARGET_SSE2 void affine_rects_sse2(float* d, std::size_t n, const batch::matrix& m)
+    {
+        const __m128 cx { _mm_setr_ps(m.xx, m.xy, std::abs(m.xx), std::abs(m.xy)) };
+        const __m128 cy { _mm_setr_ps(m.yx, m.yy, std::abs(m.yx), std::abs(m.yy)) };
+        const __m128 t { _mm_setr_ps(m.tx, m.ty, 0.0f, 0.0f) };
+
+        const __m128 ox { _mm_setr_ps(m.xx, m.xy, 0.0f, 0.0f) };
+        const __m128 oy { _mm_setr_ps(m.yx, m.yy, 0.0f, 0.0f) };
+
+        const __m128 zero { _mm_setzero_ps() };
+
+        for (std::size_t i { 0 }; i < n; ++i, d += 4)
+        {
+            const __m128 v { _mm_loadu_ps(d) };
+
+            // [x, x, w, w] and [y, y, h, h].
+            const __m128 xs { _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 0, 0)) };
+            const __m128 ys { _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 1, 1)) };
+
+            const __m128 ws { _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2)) };
+            const __m128 hs { _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3)) };
+
+            const __m128 base { _mm_add_ps(_mm_add_ps(_mm_mul_ps(xs, cx), _mm_mul_ps(ys, cy)), t) };
+            const __m128 offset { _mm_add_ps(_mm_min_ps(_mm_mul_ps(ws, ox), zero), _mm_min_ps(_mm_mul_ps(hs, oy), zero)) };
+
+            _mm_storeu_ps(d, _mm_add_ps(base, offset));
+        }
+    }
+
+    HAL_TARGET_SSE2 std::size_t intersect_sse2(const float* d, std::size_t n, const coord::rect& area, bool* out)
+    {
+        // [x, y, -(x + w), -(y + h)] <= [ax + aw, ay + ah, -ax, -ay]
+        const __m128 k { _mm_setr_ps(area.pos.x + area.size.x, area.pos.y + area.size.y, -area.pos.x, -area.pos.y) };
+        const __m128 ends { _mm_setr_ps(0.0f, 0.0f, 1.0f, 1.0f) };
+        const __m128 sign { _mm_setr_ps(1.0f, 1.0f, -1.0f, -1.0f) };
+
+        std::size_t ret { 0 };
+
+        for (std::size_t i { 0 }; i < n; ++i, d += 4)
+        {
+            const __m128 v { _mm_loadu_ps(d) };
+            const __m128 pos { _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 1, 0)) };
+            const __m128 e { _mm_mul_ps(_mm_add_ps(_mm_mul_ps(v, ends), pos), sign) };
+
+            // Same arithmetic as `operator|`, so the results match exactly.
+            out[i] = _mm_movemask_ps(_mm_cmple_ps(e, k)) == 0xF;
+            ret += out[i];
+        }
+
+        return ret;
+    }
+
+    constexpr kernel_set sse2_kernels {
+        batch::isa::sse2,
+        mul_add_sse2,
+        anchor_sse2,
+        affine_points_sse2,
+        affine_rects_sse2,
+        intersect_sse2
+    };
+
+    // ----- AVX -----
+    // Shuffles only work within 128-bit lanes, which conveniently hold one rectangle or two points.
+
+    HAL_TARGET_AVX void mul_add_avx(float* d, std::size_t n, const float* mul, const float* add)
+    {
+        const __m128 m4 { _mm_loadu_ps(mul) }, a4 { _mm_loadu_ps(add) };
+        const __m256 vm { _mm256_set_m128(m4, m4) }, va { _mm256_set_m128(a4, a4) };
+
+        std::size_t i { 0 };
+
+        for (; i + 8 <= n; i += 8)
+            _mm256_storeu_ps(d + i, _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(d + i), vm), va));
+
+        mul_add_scalar(d + i, n - i, mul, add);
+    }
+
+    HAL_TARGET_AVX void anchor_avx(float* d, std::size_t n, float kx, float ky)
+    {
+        const __m256 k { _mm256_setr_ps(kx, ky, 0.0f, 0.0f, kx, ky, 0.0f, 0.0f) };
+
+        std::size_t i { 0 };
+
+        for (; i + 2 <= n; i += 2, d += 8)
+        {
+            const __m256 v { _mm256_loadu_ps(d) };
+            const __m256 size { _mm256_permute_ps(v, _MM_SHUFFLE(3, 2, 3, 2)) };
+
+            _mm256_storeu_ps(d, _mm256_add_ps(v, _mm256_mul_ps(size, k)));
+        }
+
+        anchor_scalar(d, n - i, kx, ky);
+    }
+
+    HAL_TARGET_AVX void affine_points_avx(float* d, std::size_t n, const batch::matrix& m)
+    {
+        const __m256 cx { _mm256_setr_ps(m.xx, m.xy, m.xx, m.xy, m.xx, m.xy, m.xx, m.xy) };
+        const __m256 cy { _mm256_setr_ps(m.yx, m.yy, m.yx, m.yy, m.yx, m.yy, m.yx, m.yy) };
+        const __m256 t { _mm256_setr_ps(m.tx, m.ty, m.tx, m.ty, m.tx, m.ty, m.tx, m.ty) };
+
+        std::size_t i { 0 };
+
+        for (; i + 4 <= n; i += 4, d += 8)
+        {
+            const __m256 v { _mm256_loadu_ps(d) };
+            const __m256 xs { _mm256_permute_ps(v, _MM_SHUFFLE(2, 2, 0, 0)) };
+            const __m256 ys { _mm256_permute_ps(v, _MM_SHUFFLE(3, 3, 1, 1)) };
+
+            _mm256_storeu_ps(d, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(xs, cx), _mm256_mul_ps(ys, cy)), t));
+        }
+
+        affine_points_scalar(d, n - i, m);
+    }
+
+    HAL_TARGET_AVX void affine_rects_avx(float* d, std::size_t n, const batch::matrix& m)
+    {
+        const float ax { std::abs(m.xx) }, ay { std::abs(m.xy) }, bx { std::abs(m.yx) }, by { std::abs(m.yy) };
+
+        const __m256 cx { _mm256_setr_ps(m.xx, m.xy, ax, ay, m.xx, m.xy, ax, ay) };
+        const __m256 cy { _mm256_setr_ps(m.yx, m.yy, bx, by, m.yx, m.yy, bx, by) };
+        const __m256 t { _mm256_setr_ps(m.tx, m.ty, 0.0f, 0.0f, m.tx, m.ty, 0.0f, 0.0f) };
+
+        const __m256 ox { _mm256_setr_ps(m.xx, m.xy, 0.0f, 0.0f, m.xx, m.xy, 0.0f, 0.0f) };
+        const __m256 oy { _mm256_setr_ps(m.yx, m.yy, 0.0f, 0.0f, m.yx, m.yy, 0.0f, 0.0f) };
+
+        const __m256 zero { _mm256_setzero_ps() };
+
+        std::size_t i { 0 };
+
+        for (; i + 2 <= n; i += 2, d += 8)
+        {
+            const __m256 v { _mm256_loadu_ps(d) };
+
+            const __m256 xs { _mm256_permute_ps(v, _MM_SHUFFLE(2, 2, 0, 0)) };
+            const __m256 ys { _mm256_permute_ps(v, _MM_SHUFFLE(3, 3, 1, 1)) };
+
+            const __m256 ws { _mm256_permute_ps(v, _MM_SHUFFLE(2, 2, 2, 2)) };
+            const __m256 hs { _mm256_permute_ps(v, _MM_SHUFFLE(3, 3, 3, 3)) };
+
+            const __m256 base { _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(xs, cx), _mm256_mul_ps(ys, cy)), t) };
+            const __m256 offset { _mm256_add_ps(_mm256_min_ps(_mm256_mul_ps(ws, ox), zero), _mm256_min_ps(_mm256_mul_ps(hs, oy), zero)) };
+
+            _mm256_storeu_ps(d, _mm256_add_ps(base, offset));
+        }
+
+        affine_rects_scalar(d, n - i, m);
+    }
+
+    HAL_TARGET_AVX std::size_t intersect_avx(const float* d, std::size_t n, const coord::rect& area, bool* out)
+    {
+        const float kx { area.pos.x + area.size.x }, ky { area.pos.y + area.size.y };
+
+        const __m256 k { _mm256_setr_ps(kx, ky, -area.pos.x, -area.pos.y, kx, ky, -area.pos.x, -area.pos.y) };
+        const __m256 ends { _mm256_setr_ps(0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f) };
+        const __m256 sign { _mm256_setr_ps(1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, -1.0f, -1.0f) };
+
+        std::size_t ret { 0 }, i { 0 };
+
+        for (; i + 2 <= n; i += 2, d += 8)
+        {
+            const __m256 v { _mm256_loadu_ps(d) };
+            const __m256 pos { _mm256_permute_ps(v, _MM_SHUFFLE(1, 0, 1, 0)) };
+            const __m256 e { _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(v, ends), pos), sign) };
+
+            const int mask { _mm256_movemask_ps(_mm256_cmp_ps(e, k, _CMP_LE_OQ)) };
+
+            out[i]     = (mask & 0x0F) == 0x0F;
+            out[i + 1] = (mask & 0xF0) == 0xF0;
+
+            ret += out[i] + out[i + 1];
+        }
+
+        return ret + intersect_scalar(d, n - i, area, out + i);
+    }
+
+    constexpr kernel_set avx_kernels {
+        batch::isa::avx,
+        mul_add_avx,
+        anchor_avx,
+        affine_points_avx,
+        affine_rects_avx,
+        intersect_avx
+    };
+#endif
+
+    const kernel_set& select_kernels()
+    {
+#ifdef HAL_SIMD_X86
+        if (cpu::avx())
+            return avx_kernels;
+
+        if (cpu::sse2())
+            return sse2_kernels;
+#endif
+
+        return scalar_kernels;
+    }
+
+    // Chosen once, upon first use.
+    const kernel_set& kernels()
+    {
+        static const kernel_set& ks { select_kernels() };
+        return ks;
+    }
+
+    float* floats(std::span<coord::point> pts)
+    {
+        return reinterpret_cast<float*>(pts.data());
+    }
+
+    float* floats(std::span<coord::rect> rects)
+    {
+        return reinterpret_cast<float*>(rects.data());
+    }
+}
+
+batch::isa batch::instruction_set()
+{
+    return kernels().set;
+}
+
+void batch::translate(std::span<coord::point> pts, coord::point offset)
+{
+    const float mul[4] { 1.0f, 1.0f, 1.0f, 1.0f };
+    const float add[4] { offset.x, offset.y, offset.x, offset.y };
+
+    kernels().mul_add(floats(pts), pts.size() * 2, mul, add);
+}
+
+void batch::translate(std::span<coord::rect> rects, coord::point offset)
+{
+    const float mul[4] { 1.0f, 1.0f, 1.0f, 1.0f };
+    const float add[4] { offset.x, offset.y, 0.0f, 0.0f };
+
+    kernels().mul_add(floats(rects), rects.size() * 4, mul, add);
+}
+
+void batch::scale(std::span<coord::point> pts, coord::point factor)
+{
+    const float mul[4] { factor.x, factor.y, factor.x, factor.y };
+    const float add[4] { 0.0f, 0.0f, 0.0f, 0.0f };
+
+    kernels().mul_add(floats(pts), pts.size() * 2, mul, add);
+}
+
+void batch::scale(std::span<coord::rect> rects, coord::point factor)
+{
+    const float mul[4] { factor.x, factor.y, factor.x, factor.y };
+    const float add[4] { 0.0f, 0.0f, 0.0f, 0.0f };
+
+    kernels().mul_add(floats(rects), rects.size() * 4, mul, add);
+}
+
+void batch::affine(std::span<coord::point> pts, const matrix& m)
+{
+    kernels().affine_points(floats(pts), pts.size(), m);
+}
+
+void batch::affine(std::span<coord::rect> rects, const matrix& m)
+{
+    kernels().affine_rects(floats(rects), rects.size(), m);
+}
+
+void batch::anchor(std::span<coord::rect> rects, hal::anchor a)
+{
+    // Mirrors `point::anchor()`.
+    float kx { 0.0f }, ky { 0.0f };
+
+    switch (a)
+    {
+        using enum hal::anchor;
+
+    case center:
+        kx = ky = -0.5f;
+        break;
+
+    case top_left:
+        return;
+
+    case top_right:
+        kx = 1.0f;
+        break;
+
+    case bottom_left:
+        ky = 1.0f;
+        break;
+
+    case bottom_right:
+        kx = ky = 1.0f;
+        break;
+    }
+
+    kernels().anchor(floats(rects), rects.size(), kx, ky);
+}
+
+std::size_t batch::intersect(std::span<const coord::rect> rects, const coord::rect& area, std::span<bool> out)
+{
+    HAL_ASSERT(out.size() >= rects.size(), "Output span is smaller than the input");
+
+    return kernels().intersect(reinterpret_cast<const float*>(rects.data()), rects.size(), area, out.data());
+}
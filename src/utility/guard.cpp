@@ -1,5 +1,7 @@
 #include <halcyon/utility/guard.hpp>
 
+#include <halcyon/video/texture.hpp>
+
 using namespace hal;
 
 guard::lock::lock(lref<streaming_texture> tex)
@@ -36,15 +38,23 @@ void guard::color::set(hal::color c)
     m_ref->color(c);
 }
 
-guard::target::target(lref<renderer> obj, ref<target_texture> tx)
+guard::target::target(lref<renderer> obj)
     : m_ref { obj }
+    , m_old { ::SDL_GetRenderTarget(obj.get()) }
+{
+}
+
+guard::target::target(lref<renderer> obj, ref<target_texture> tx)
+    : target { obj }
 {
     set(tx);
 }
 
 guard::target::~target()
 {
-    m_ref->reset_target();
+    // SDL validates textures, so setting a destroyed one fails instead of using it.
+    if (m_old == nullptr || !m_ref->target(ref<target_texture>::from_ptr(m_old)))
+        m_ref->reset_target();
 }
 
 void guard::target::set(ref<target_texture> tx)
@@ -0,0 +1,90 @@
+#include <halcyon/utility/thread_pool.hpp>
+
+using namespace hal;
+
+thread_pool::thread_pool()
+    : thread_pool { std::max(std::thread::hardware_concurrency(), 2u) - 1 }
+{
+}
+
+thread_pool::thread_pool(std::size_t workers)
+    : m_active { 0 }
+{
+    workers = std::max<std::size_t>(workers, 1);
+
+    m_workers.reserve(workers);
+
+    for (std::size_t i { 0 }; i < workers; ++i)
+        m_workers.emplace_back([this](std::stop_token st)
+            { run(st); });
+}
+
+thread_pool::~thread_pool()
+{
+    wait();
+
+    {
+        // Stops are requested under the lock, lest a worker miss the notification.
+        std::lock_guard _ { m_mutex };
+
+        for (std::jthread& t : m_workers)
+            t.request_stop();
+    }
+
+    m_taskAdded.notify_all();
+}
+
+void thread_pool::push(task t)
+{
+    {
+        std::lock_guard _ { m_mutex };
+        m_tasks.push_back(std::move(t));
+    }
+
+    m_taskAdded.notify_one();
+}
+
+void thread_pool::wait()
+{
+    std::unique_lock lock { m_mutex };
+
+    m_taskDone.wait(lock, [this]
+        { return m_tasks.empty() && m_active == 0; });
+}
+
+std::size_t thread_pool::size() const
+{
+    return m_workers.size();
+}
+
+void thread_pool::run(std::stop_token st)
+{
+    while (true)
+    {
+        task t;
+
+        {
+            std::unique_lock lock { m_mutex };
+
+            m_taskAdded.wait(lock, [&]
+                { return !m_tasks.empty() || st.stop_requested(); });
+
+            if (m_tasks.empty())
+                return;
+
+            t = std::move(m_tasks.front());
+            m_tasks.pop_front();
+
+            ++m_active;
+        }
+
+        t();
+
+        {
+            std::lock_guard _ { m_mutex };
+            --m_active;
+        }
+
+        m_taskDone.notify_all();
+    }
+}
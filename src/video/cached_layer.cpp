@@ -0,0 +1,56 @@
+#include <halcyon/video/cached_layer.hpp>
+
+using namespace hal;
+
+namespace
+{
+    // Blending onto a transparent target results in premultiplied colors.
+    constexpr blend_mode layer_blend { blend_mode::alpha_premul };
+}
+
+cached_layer::cached_layer(lref<renderer> rnd, pixel::point size)
+    : m_renderer { rnd }
+    , m_texture { rnd, size, pixel::format::rgba32 }
+    , m_dirty { true }
+{
+    m_texture.blend(layer_blend);
+}
+
+void cached_layer::invalidate()
+{
+    m_dirty = true;
+}
+
+bool cached_layer::dirty() const
+{
+    return m_dirty;
+}
+
+bool cached_layer::resize(pixel::point size)
+{
+    m_texture = { m_renderer, size, pixel::format::rgba32 };
+    m_dirty   = true;
+
+    return m_texture.valid() && m_texture.blend(layer_blend);
+}
+
+copyer cached_layer::draw()
+{
+    return m_renderer->draw(m_texture);
+}
+
+const target_texture& cached_layer::texture() const
+{
+    return m_texture;
+}
+
+bool cached_layer::begin()
+{
+    if (!m_renderer->target(m_texture))
+        return false;
+
+    guard::color _ { m_renderer, colors::transparent };
+    m_renderer->clear();
+
+    return true;
+}
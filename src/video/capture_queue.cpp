@@ -0,0 +1,197 @@
+#include <halcyon/video/capture_queue.hpp>
+
+#include <halcyon/image.hpp>
+#include <halcyon/utility/guard.hpp>
+#include <halcyon/utility/thread_pool.hpp>
+
+#include <algorithm>
+
+using namespace hal;
+
+capture_queue::capture_queue(lref<renderer> rnd, std::size_t delay)
+    : m_renderer { rnd }
+    , m_pool { nullptr }
+    , m_delay { delay }
+    , m_frame { 0 }
+    , m_next { 0 }
+{
+}
+
+capture_queue::capture_queue(lref<renderer> rnd, thread_pool& pool, std::size_t delay)
+    : capture_queue { rnd, delay }
+{
+    m_pool = &pool;
+}
+
+capture_queue::ticket capture_queue::capture()
+{
+    return capture(handler {});
+}
+
+capture_queue::ticket capture_queue::capture(handler h)
+{
+    SDL_Texture* const target { ::SDL_GetRenderTarget(m_renderer.get()) };
+
+    if (target != nullptr)
+        return stage(ref<texture>::from_ptr(target), std::move(h));
+
+    // The window's contents can't be drawn elsewhere, so this has to stall.
+    const ticket id { m_next++ };
+    deliver(id, m_renderer->read_pixels(), std::move(h));
+
+    return id;
+}
+
+capture_queue::ticket capture_queue::capture(ref<texture> src)
+{
+    return stage(src, handler {});
+}
+
+capture_queue::ticket capture_queue::capture(ref<texture> src, handler h)
+{
+    return stage(src, std::move(h));
+}
+
+std::size_t capture_queue::update()
+{
+    ++m_frame;
+
+    return read_back(m_delay);
+}
+
+std::size_t capture_queue::flush()
+{
+    return read_back(0);
+}
+
+surface capture_queue::take(ticket t)
+{
+    const auto iter = std::ranges::find(m_done, t, &std::pair<ticket, surface>::first);
+
+    if (iter == m_done.end())
+        return {};
+
+    surface ret { std::move(iter->second) };
+    m_done.erase(iter);
+
+    return ret;
+}
+
+std::size_t capture_queue::pending() const
+{
+    return m_pending.size();
+}
+
+capture_queue::handler capture_queue::png(outputter dst)
+{
+    return [dst = std::move(dst)](surface s) mutable
+    {
+        image::save::png(s, std::move(dst));
+    };
+}
+
+capture_queue::ticket capture_queue::stage(ref<texture> src, handler h)
+{
+    const pixel::point  size { src->size().get_or({}) };
+    const pixel::format fmt { src->pixel_format().get_or(pixel::format::rgba32) };
+
+    // Reuse a staging texture of a previous capture, if one fits.
+    const auto iter = std::ranges::find_if(m_staging, [&](const target_texture& tx)
+        { return tx.size().get_or({}) == size && tx.pixel_format().get_or(pixel::format::unknown) == fmt; });
+
+    target_texture staging;
+
+    if (iter != m_staging.end())
+    {
+        staging = std::move(*iter);
+        m_staging.erase(iter);
+    }
+
+    else
+        staging = { m_renderer, size, fmt };
+
+    const ticket id { m_next++ };
+
+    {
+        // Copy the pixels exactly as they are.
+        guard::blend<texture>     bm { src, blend_mode::none };
+        guard::color_mod<texture> cm { src, colors::white };
+
+        const color::value_t alpha { src->alpha_mod().get_or(color::opaque) };
+        src->alpha_mod(color::opaque);
+
+        guard::target _ { m_renderer };
+
+        if (!m_renderer->target(staging) || !m_renderer->draw(src).to(tag::fill).render())
+            staging.reset();
+
+        src->alpha_mod(alpha);
+    }
+
+    // If staging fails (i.e. out of memory), read the source right away, if it's a target.
+    if (!staging.valid())
+    {
+        surface s;
+
+        {
+            guard::target _ { m_renderer };
+
+            if (m_renderer->target(ref<target_texture>::from_ptr(src.get())))
+                s = m_renderer->read_pixels();
+        }
+
+        deliver(id, std::move(s), std::move(h));
+
+        return id;
+    }
+
+    m_pending.push_back({ id, m_frame, std::move(staging), std::move(h) });
+
+    return id;
+}
+
+void capture_queue::deliver(ticket id, surface s, handler h)
+{
+    if (!h)
+        m_done.emplace_back(id, std::move(s));
+
+    else if (m_pool != nullptr)
+        m_pool->push([h = std::move(h), s = std::move(s)]() mutable
+            { h(std::move(s)); });
+
+    else
+        h(std::move(s));
+}
+
+std::size_t capture_queue::read_back(std::size_t max_age)
+{
+    std::size_t ret { 0 };
+
+    while (!m_pending.empty() && m_frame - m_pending.front().frame >= max_age)
+    {
+        capture_data cd { std::move(m_pending.front()) };
+        m_pending.pop_front();
+
+        surface s;
+
+        {
+            guard::target _ { m_renderer };
+
+            if (m_renderer->target(cd.staging))
+                s = m_renderer->read_pixels();
+        }
+
+        // Keep as many spare textures as capturing once per frame needs. Reused ones are
+        // taken out, so the front holds those unused the longest (i.e. of an old window size).
+        m_staging.push_back(std::move(cd.staging));
+
+        if (m_staging.size() > m_delay + 1)
+            m_staging.erase(m_staging.begin());
+
+        deliver(cd.id, std::move(s), std::move(cd.func));
+
+        ++ret;
+    }
+
+    return ret;
+}
@@ -0,0 +1,468 @@
+#include <halcyon/video/command_buffer.hpp>
+
+#include <halcyon/utility/guard.hpp>
+
+#include <halcyon/internal/render_stats.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <tuple>
+#include <utility>
+
+using namespace hal;
+
+namespace
+{
+    using command = command_buffer::command;
+    using kind    = command::kind;
+
+    // Mirrors `detail::drawer::unset_pos()`.
+    const SDL_FRect* rect_or_null(const coord::rect& r)
+    {
+        return r.pos.x == std::numeric_limits<coord_t>::max() ? nullptr : r.sdl_ptr();
+    }
+
+    auto sort_key(const command& c)
+    {
+        return std::tuple {
+            c.layer,
+            c.target,
+            c.texture,
+            std::to_underlying(c.blend),
+            std::bit_cast<color::hex_t>(c.color),
+            std::to_underlying(c.type)
+        };
+    }
+
+    // The area a command draws to, conservatively.
+    coord::rect bounds_of(const command& c)
+    {
+        switch (c.type)
+        {
+        case kind::point:
+            return { c.dst.pos, {} };
+
+        case kind::line:
+        {
+            const coord::point tl { std::min(c.dst.pos.x, c.dst.size.x), std::min(c.dst.pos.y, c.dst.size.y) };
+            const coord::point br { std::max(c.dst.pos.x, c.dst.size.x), std::max(c.dst.pos.y, c.dst.size.y) };
+
+            return { tl, br - tl };
+        }
+
+        case kind::copy_rotated:
+            return detail::rotated_bounds(c.dst);
+
+        default:
+            return c.dst;
+        }
+    }
+
+    // Whether two commands can be merged into a single SDL call.
+    bool mergeable(const command& a, const command& b)
+    {
+        return a.type == b.type && a.layer == b.layer && a.target == b.target && a.blend == b.blend && a.color == b.color;
+    }
+}
+
+// ----- RECORDER -----
+
+recorder::recorder(ref<const texture> tx, ref<renderer> rnd, command_buffer& buf)
+    : drawer { tx, rnd }
+    , m_buffer { &buf }
+{
+}
+
+void recorder::render()
+{
+    if (culled(m_posDst))
+        return;
+
+    command c { m_buffer->make(kind::copy, m_posDst) };
+
+    c.texture = m_drawSrc.get();
+    c.src     = m_posSrc;
+
+    // Draw state doesn't apply to copies; don't let it split them apart when sorting.
+    c.color = colors::black;
+    c.blend = blend_mode::none;
+
+    m_buffer->push(c);
+}
+
+void recorder::rotated(double angle, flip f)
+{
+    if (culled(detail::rotated_bounds(m_posDst)))
+        return;
+
+    command c { m_buffer->make(kind::copy_rotated, m_posDst) };
+
+    c.texture   = m_drawSrc.get();
+    c.src       = m_posSrc;
+    c.angle     = angle;
+    c.flip_mode = f;
+
+    c.color = colors::black;
+    c.blend = blend_mode::none;
+
+    m_buffer->push(c);
+}
+
+// ----- COMMAND BUFFER -----
+
+command_buffer::command_buffer(lref<renderer> rnd)
+    : m_renderer { rnd }
+    , m_target { nullptr }
+    , m_cullArea {}
+    , m_layer { 0 }
+    , m_color { colors::black }
+    , m_blend { blend_mode::none }
+    , m_sorted { true }
+    , m_cull { false }
+{
+}
+
+void command_buffer::layer(layer_t l)
+{
+    m_layer = l;
+}
+
+command_buffer::layer_t command_buffer::layer() const
+{
+    return m_layer;
+}
+
+void command_buffer::color(hal::color c)
+{
+    m_color = c;
+}
+
+color command_buffer::color() const
+{
+    return m_color;
+}
+
+void command_buffer::blend(blend_mode bm)
+{
+    m_blend = bm;
+}
+
+blend_mode command_buffer::blend() const
+{
+    return m_blend;
+}
+
+void command_buffer::target(ref<target_texture> tx)
+{
+    m_target = tx.get();
+}
+
+void command_buffer::reset_target()
+{
+    m_target = nullptr;
+}
+
+void command_buffer::cull(coord::rect area)
+{
+    m_cullArea = area;
+    m_cull     = true;
+}
+
+void command_buffer::reset_cull()
+{
+    m_cull = false;
+}
+
+void command_buffer::draw(coord::point pt)
+{
+    push(make(kind::point, pt));
+}
+
+void command_buffer::draw(coord::point pt, hal::color c)
+{
+    command cmd { make(kind::point, pt) };
+    cmd.color = c;
+
+    push(cmd);
+}
+
+void command_buffer::draw(std::span<const coord::point> pts)
+{
+    for (const coord::point& pt : pts)
+        draw(pt);
+}
+
+void command_buffer::draw(std::span<const coord::point> pts, hal::color c)
+{
+    for (const coord::point& pt : pts)
+        draw(pt, c);
+}
+
+void command_buffer::draw(coord::point from, coord::point to)
+{
+    push(make(kind::line, { from, to }));
+}
+
+void command_buffer::draw(coord::point from, coord::point to, hal::color c)
+{
+    command cmd { make(kind::line, { from, to }) };
+    cmd.color = c;
+
+    push(cmd);
+}
+
+void command_buffer::draw(coord::rect area)
+{
+    push(make(kind::outline, area));
+}
+
+void command_buffer::draw(coord::rect area, hal::color c)
+{
+    command cmd { make(kind::outline, area) };
+    cmd.color = c;
+
+    push(cmd);
+}
+
+void command_buffer::draw(std::span<const coord::rect> areas)
+{
+    for (const coord::rect& r : areas)
+        draw(r);
+}
+
+void command_buffer::draw(std::span<const coord::rect> areas, hal::color c)
+{
+    for (const coord::rect& r : areas)
+        draw(r, c);
+}
+
+recorder command_buffer::draw(ref<const texture> tx)
+{
+    return { tx, m_renderer, *this };
+}
+
+void command_buffer::fill(coord::rect area)
+{
+    push(make(kind::fill, area));
+}
+
+void command_buffer::fill(coord::rect area, hal::color c)
+{
+    command cmd { make(kind::fill, area) };
+    cmd.color = c;
+
+    push(cmd);
+}
+
+void command_buffer::fill(std::span<const coord::rect> areas)
+{
+    for (const coord::rect& r : areas)
+        fill(r);
+}
+
+void command_buffer::fill(std::span<const coord::rect> areas, hal::color c)
+{
+    for (const coord::rect& r : areas)
+        fill(r, c);
+}
+
+void command_buffer::sort()
+{
+    if (m_sorted)
+        return;
+
+    std::ranges::stable_sort(m_commands, {}, sort_key);
+
+    m_sorted = true;
+}
+
+void command_buffer::merge(const command_buffer& other)
+{
+    const std::size_t old_size { m_commands.size() };
+
+    m_commands.insert(m_commands.end(), other.m_commands.begin(), other.m_commands.end());
+
+    if (m_sorted && other.m_sorted)
+    {
+        const auto middle = m_commands.begin() + static_cast<std::ptrdiff_t>(old_size);
+        std::ranges::inplace_merge(m_commands, middle, {}, sort_key);
+    }
+
+    else
+        m_sorted = false;
+}
+
+bool command_buffer::submit()
+{
+    sort();
+
+    SDL_Renderer* const rnd { m_renderer.get() };
+
+    // Remember the renderer's state; it gets restored at the end.
+    guard::target      old_target { m_renderer };
+    result<hal::color> old_color { m_renderer->color() };
+    result<blend_mode> old_blend { m_renderer->blend() };
+
+    SDL_Texture* target { ::SDL_GetRenderTarget(rnd) };
+    hal::color   clr { old_color.get_or(colors::black) };
+    blend_mode   bm { old_blend.get_or(blend_mode::none) };
+
+    bool ret { true };
+
+    for (std::size_t i { 0 }; i < m_commands.size();)
+    {
+        const command& c { m_commands[i] };
+
+        if (c.target != target)
+        {
+            detail::count_target_switch(rnd, c.target);
+
+            ret &= ::SDL_SetRenderTarget(rnd, c.target);
+            target = c.target;
+        }
+
+        // Texture copies don't depend on the draw color and blend mode.
+        if (c.type == kind::copy)
+        {
+            ret &= ::SDL_RenderTexture(rnd, c.texture, rect_or_null(c.src), rect_or_null(c.dst));
+            ++i;
+
+            detail::count_copy(rnd, c.texture);
+
+            continue;
+        }
+
+        if (c.type == kind::copy_rotated)
+        {
+            ret &= ::SDL_RenderTextureRotated(rnd, c.texture, rect_or_null(c.src), rect_or_null(c.dst), c.angle, nullptr, static_cast<SDL_FlipMode>(c.flip_mode));
+            ++i;
+
+            detail::count_copy(rnd, c.texture);
+
+            continue;
+        }
+
+        if (c.color != clr)
+        {
+            ret &= ::SDL_SetRenderDrawColor(rnd, c.color.r, c.color.g, c.color.b, c.color.a);
+            clr = c.color;
+        }
+
+        if (c.blend != bm)
+        {
+            ret &= ::SDL_SetRenderDrawBlendMode(rnd, static_cast<SDL_BlendMode>(c.blend));
+            bm = c.blend;
+        }
+
+        // Find the run of commands that can be merged with this one.
+        std::size_t end { i + 1 };
+
+        while (end < m_commands.size() && mergeable(c, m_commands[end]))
+            ++end;
+
+        const std::span<const command> run { m_commands.begin() + static_cast<std::ptrdiff_t>(i), m_commands.begin() + static_cast<std::ptrdiff_t>(end) };
+
+        switch (c.type)
+        {
+        case kind::point:
+            m_scratchPoints.clear();
+
+            for (const command& rc : run)
+                m_scratchPoints.push_back(rc.dst.pos);
+
+            ret &= ::SDL_RenderPoints(rnd, m_scratchPoints.front().sdl_ptr(), static_cast<int>(m_scratchPoints.size()));
+            detail::count_draw(rnd, run.size());
+
+            break;
+
+        case kind::line:
+            // Lines can't be batched without connecting them.
+            for (const command& rc : run)
+            {
+                ret &= ::SDL_RenderLine(rnd, rc.dst.pos.x, rc.dst.pos.y, rc.dst.size.x, rc.dst.size.y);
+                detail::count_draw(rnd, 1);
+            }
+
+            break;
+
+        case kind::outline:
+        case kind::fill:
+            m_scratchRects.clear();
+
+            for (const command& rc : run)
+                m_scratchRects.push_back(rc.dst);
+
+            ret &= c.type == kind::fill
+                ? ::SDL_RenderFillRects(rnd, m_scratchRects.front().sdl_ptr(), static_cast<int>(m_scratchRects.size()))
+                : ::SDL_RenderRects(rnd, m_scratchRects.front().sdl_ptr(), static_cast<int>(m_scratchRects.size()));
+
+            detail::count_draw(rnd, run.size());
+
+            break;
+
+        default:
+            break;
+        }
+
+        i = end;
+    }
+
+    if (old_color.valid() && clr != old_color.get())
+        m_renderer->color(old_color.get());
+
+    if (old_blend.valid() && bm != old_blend.get())
+        m_renderer->blend(old_blend.get());
+
+    return ret;
+}
+
+void command_buffer::clear()
+{
+    m_commands.clear();
+    m_sorted = true;
+}
+
+std::span<const command> command_buffer::commands() const
+{
+    return m_commands;
+}
+
+std::size_t command_buffer::size() const
+{
+    return m_commands.size();
+}
+
+bool command_buffer::empty() const
+{
+    return m_commands.empty();
+}
+
+command command_buffer::make(command::kind k, coord::rect dst) const
+{
+    return {
+        .layer     = m_layer,
+        .target    = m_target,
+        .texture   = nullptr,
+        .blend     = m_blend,
+        .color     = m_color,
+        .type      = k,
+        .flip_mode = flip::none,
+        .angle     = 0.0,
+        .src       = {},
+        .dst       = dst
+    };
+}
+
+void command_buffer::push(const command& cmd)
+{
+    // Copies to the whole target are never culled.
+    if (m_cull && cmd.dst.pos.x != std::numeric_limits<coord_t>::max() && !(bounds_of(cmd) | m_cullArea))
+        return;
+
+    // Appending in order keeps the buffer sorted; no need to sort it again.
+    if (m_sorted && !m_commands.empty() && sort_key(cmd) < sort_key(m_commands.back()))
+        m_sorted = false;
+
+    m_commands.push_back(cmd);
+}
@@ -0,0 +1,175 @@
+#include <halcyon/video/dirty_region.hpp>
+
+#include <algorithm>
+#include <limits>
+
+using namespace hal;
+
+namespace
+{
+    std::int64_t area_of(const pixel::rect& r)
+    {
+        return static_cast<std::int64_t>(r.size.x) * r.size.y;
+    }
+
+    pixel::rect bounding_box(const pixel::rect& a, const pixel::rect& b)
+    {
+        const pixel::point tl { std::min(a.pos.x, b.pos.x), std::min(a.pos.y, b.pos.y) };
+        const pixel::point br { std::max(a.pos.x + a.size.x, b.pos.x + b.size.x), std::max(a.pos.y + a.size.y, b.pos.y + b.size.y) };
+
+        return { tl, br - tl };
+    }
+
+    std::int64_t overlap_of(const pixel::rect& a, const pixel::rect& b)
+    {
+        const pixel_t w { std::min(a.pos.x + a.size.x, b.pos.x + b.size.x) - std::max(a.pos.x, b.pos.x) };
+        const pixel_t h { std::min(a.pos.y + a.size.y, b.pos.y + b.size.y) - std::max(a.pos.y, b.pos.y) };
+
+        return w > 0 && h > 0 ? static_cast<std::int64_t>(w) * h : 0;
+    }
+
+    // The area of the bounding box covered by neither rectangle.
+    std::int64_t waste_of(const pixel::rect& a, const pixel::rect& b)
+    {
+        return area_of(bounding_box(a, b)) - (area_of(a) + area_of(b) - overlap_of(a, b));
+    }
+}
+
+dirty_region::dirty_region(pixel::point bounds)
+    : dirty_region { bounds, merge_policy {} }
+{
+}
+
+dirty_region::dirty_region(pixel::point bounds, merge_policy mp)
+    : m_bounds { bounds }
+    , m_policy { mp }
+{
+}
+
+void dirty_region::add(pixel::rect area)
+{
+    // Clip to the tracked area, if there is one.
+    if (m_bounds.x != 0 && m_bounds.y != 0)
+    {
+        const pixel::point tl { std::max(area.pos.x, 0), std::max(area.pos.y, 0) };
+        const pixel::point br { std::min(area.pos.x + area.size.x, m_bounds.x), std::min(area.pos.y + area.size.y, m_bounds.y) };
+
+        area = { tl, br - tl };
+    }
+
+    if (area.size.x <= 0 || area.size.y <= 0)
+        return;
+
+    // Keep absorbing rectangles until nothing else qualifies, since
+    // a grown rectangle might now be worth merging with another one.
+    for (auto iter = m_rects.begin(); iter != m_rects.end();)
+    {
+        const pixel::rect merged { bounding_box(area, *iter) };
+
+        if (static_cast<float>(waste_of(area, *iter)) <= m_policy.max_waste * static_cast<float>(area_of(merged)))
+        {
+            area = merged;
+            m_rects.erase(iter);
+            iter = m_rects.begin();
+        }
+
+        else
+            ++iter;
+    }
+
+    m_rects.push_back(area);
+
+    enforce_limit();
+}
+
+void dirty_region::add_all()
+{
+    if (m_bounds.x != 0 && m_bounds.y != 0)
+    {
+        m_rects.clear();
+        m_rects.push_back({ tag::as_size, m_bounds });
+    }
+}
+
+void dirty_region::clear()
+{
+    m_rects.clear();
+}
+
+bool dirty_region::empty() const
+{
+    return m_rects.empty();
+}
+
+std::span<const pixel::rect> dirty_region::rects() const
+{
+    return m_rects;
+}
+
+pixel::rect dirty_region::extent() const
+{
+    if (m_rects.empty())
+        return {};
+
+    pixel::rect ret { m_rects.front() };
+
+    for (const pixel::rect& r : m_rects)
+        ret = bounding_box(ret, r);
+
+    return ret;
+}
+
+std::int64_t dirty_region::area() const
+{
+    std::int64_t ret { 0 };
+
+    for (const pixel::rect& r : m_rects)
+        ret += area_of(r);
+
+    return ret;
+}
+
+pixel::point dirty_region::bounds() const
+{
+    return m_bounds;
+}
+
+const dirty_region::merge_policy& dirty_region::policy() const
+{
+    return m_policy;
+}
+
+void dirty_region::policy(merge_policy mp)
+{
+    m_policy = mp;
+    enforce_limit();
+}
+
+void dirty_region::enforce_limit()
+{
+    const std::size_t limit { std::max<std::size_t>(m_policy.max_rects, 1) };
+
+    while (m_rects.size() > limit)
+    {
+        std::size_t  best_i { 0 }, best_j { 1 };
+        std::int64_t best_waste { std::numeric_limits<std::int64_t>::max() };
+
+        for (std::size_t i { 0 }; i < m_rects.size(); ++i)
+        {
+            for (std::size_t j { i + 1 }; j < m_rects.size(); ++j)
+            {
+                const std::int64_t w { waste_of(m_rects[i], m_rects[j]) };
+
+                if (w < best_waste)
+                {
+                    best_waste = w;
+                    best_i     = i;
+                    best_j     = j;
+                }
+            }
+        }
+
+        m_rects[best_i] = bounding_box(m_rects[best_i], m_rects[best_j]);
+        m_rects.erase(m_rects.begin() + static_cast<std::ptrdiff_t>(best_j));
+    }
+}
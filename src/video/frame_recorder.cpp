@@ -0,0 +1,258 @@
+#include <halcyon/video/frame_recorder.hpp>
+
+#include <halcyon/internal/qoi.hpp>
+#include <halcyon/utility/thread_pool.hpp>
+
+#include <algorithm>
+
+using namespace hal;
+
+namespace
+{
+    // Recorded frames are RGBA32 and tightly packed, regardless of the renderer's format.
+    constexpr pixel::format frame_format { pixel::format::rgba32 };
+
+    std::vector<std::uint8_t> encode_rgba(const SDL_Surface& s)
+    {
+        const std::size_t row_size { std::size_t(s.w) * 4 };
+
+        std::vector<std::uint8_t> ret(row_size * s.h);
+
+        for (int y { 0 }; y < s.h; ++y)
+            std::copy_n(static_cast<const std::uint8_t*>(s.pixels) + y * s.pitch, row_size, ret.data() + y * row_size);
+
+        return ret;
+    }
+
+    std::uint8_t luma(int r, int g, int b)
+    {
+        return static_cast<std::uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+    }
+
+    // Full-resolution luma followed by both chroma planes, subsampled by averaging 2x2 blocks.
+    std::vector<std::uint8_t> encode_yuv420(const SDL_Surface& s)
+    {
+        const int cw { (s.w + 1) / 2 }, ch { (s.h + 1) / 2 };
+
+        std::vector<std::uint8_t> ret(std::size_t(s.w) * s.h + 2 * std::size_t(cw) * ch);
+
+        std::uint8_t* y_plane { ret.data() };
+        std::uint8_t* u_plane { y_plane + std::size_t(s.w) * s.h };
+        std::uint8_t* v_plane { u_plane + std::size_t(cw) * ch };
+
+        const auto at = [&](int x, int y)
+        {
+            return static_cast<const std::uint8_t*>(s.pixels) + y * s.pitch + x * 4;
+        };
+
+        for (int y { 0 }; y < s.h; ++y)
+            for (int x { 0 }; x < s.w; ++x)
+            {
+                const std::uint8_t* px { at(x, y) };
+                *y_plane++ = luma(px[0], px[1], px[2]);
+            }
+
+        for (int y { 0 }; y < ch; ++y)
+            for (int x { 0 }; x < cw; ++x)
+            {
+                // Blocks at odd edges reuse their last row/column.
+                const int x0 { x * 2 }, x1 { std::min(x0 + 1, s.w - 1) };
+                const int y0 { y * 2 }, y1 { std::min(y0 + 1, s.h - 1) };
+
+                int r { 0 }, g { 0 }, b { 0 };
+
+                for (const std::uint8_t* px : { at(x0, y0), at(x1, y0), at(x0, y1), at(x1, y1) })
+                {
+                    r += px[0];
+                    g += px[1];
+                    b += px[2];
+                }
+
+                r = (r + 2) / 4;
+                g = (g + 2) / 4;
+                b = (b + 2) / 4;
+
+                *u_plane++ = static_cast<std::uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+                *v_plane++ = static_cast<std::uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+            }
+
+        return ret;
+    }
+}
+
+frame_recorder::frame_recorder(lref<renderer> rnd, outputter dst, thread_pool& pool, format fmt, std::size_t max_queued)
+    : m_renderer { rnd }
+    , m_output { std::move(dst) }
+    , m_pool { pool }
+    , m_captures { rnd }
+    , m_format { fmt }
+    , m_maxQueued { std::max<std::size_t>(max_queued, 1) }
+    , m_size { 0, 0 }
+    , m_allocated { 0 }
+    , m_recorded { 0 }
+    , m_written { 0 }
+    , m_failed { !m_output.valid() }
+{
+}
+
+frame_recorder::~frame_recorder()
+{
+    finish();
+}
+
+bool frame_recorder::record()
+{
+    // Frames are numbered when captured, so that captures read back out of order
+    // (i.e. of the window, which are read immediately) are still written in order.
+    const std::size_t index { m_recorded++ };
+
+    // Handlers run in the queue's `update()`, on this thread; running them on the pool
+    // could block every worker in `acquire()` while the encoding they wait for can't run.
+    m_captures.capture([this, index](surface read)
+        { submit(index, std::move(read)); });
+
+    std::lock_guard _ { m_mutex };
+
+    return !m_failed;
+}
+
+void frame_recorder::update()
+{
+    m_captures.update();
+}
+
+bool frame_recorder::finish()
+{
+    m_captures.flush();
+
+    std::unique_lock lock { m_mutex };
+
+    m_changed.wait(lock, [this]
+        { return m_written == m_recorded; });
+
+    if (m_output.valid())
+        m_failed |= !::SDL_FlushIO(m_output.get());
+
+    return !m_failed;
+}
+
+std::size_t frame_recorder::frames() const
+{
+    std::lock_guard _ { m_mutex };
+
+    return m_written;
+}
+
+pixel::point frame_recorder::size() const
+{
+    return m_size;
+}
+
+void frame_recorder::submit(std::size_t index, surface read)
+{
+    if (read.valid() && m_size == pixel::point { 0, 0 })
+        m_size = read.size();
+
+    // Without a size (or a surface) to make an empty frame of, all that's left is to skip this one.
+    surface frame { m_size == pixel::point { 0, 0 } ? surface {} : acquire() };
+
+    if (!frame.valid())
+    {
+        std::lock_guard _ { m_mutex };
+
+        write(index, {});
+        m_changed.notify_all();
+
+        return;
+    }
+
+    bool copied { false };
+
+    if (read.valid())
+    {
+        // The previous contents of a reused surface must not be blended with.
+        read.blend(blend_mode::none);
+
+        copied = read.size() == m_size ? read.blit(frame).blit() : read.blit(frame).to(tag::fill).scaled(scale_mode::linear);
+    }
+
+    if (!copied)
+    {
+        // Keep the stream intact (and other frames in order) with an empty frame.
+        frame.fill(colors::black);
+
+        std::lock_guard _ { m_mutex };
+        m_failed = true;
+    }
+
+    m_pool.push([this, index, frame = std::move(frame)]() mutable
+        { encode(index, std::move(frame)); });
+}
+
+surface frame_recorder::acquire()
+{
+    std::unique_lock lock { m_mutex };
+
+    if (m_free.empty() && m_allocated < m_maxQueued)
+    {
+        ++m_allocated;
+        lock.unlock();
+
+        return { m_size, frame_format };
+    }
+
+    m_changed.wait(lock, [this]
+        { return !m_free.empty(); });
+
+    surface ret { std::move(m_free.back()) };
+    m_free.pop_back();
+
+    return ret;
+}
+
+void frame_recorder::encode(std::size_t index, surface frame)
+{
+    std::vector<std::uint8_t> data;
+
+    switch (m_format)
+    {
+    case format::rgba:
+        data = encode_rgba(*frame);
+        break;
+
+    case format::yuv420:
+        data = encode_yuv420(*frame);
+        break;
+
+    case format::qoi:
+        data = detail::encode_qoi(frame);
+        break;
+    }
+
+    std::lock_guard _ { m_mutex };
+
+    m_free.push_back(std::move(frame));
+
+    write(index, std::move(data));
+
+    m_changed.notify_all();
+}
+
+void frame_recorder::write(std::size_t index, std::vector<std::uint8_t> data)
+{
+    if (data.empty())
+        m_failed = true;
+
+    m_encoded.emplace(index, std::move(data));
+
+    // Write whatever is next in line; later frames wait for the one in front of them.
+    for (auto iter = m_encoded.begin(); iter != m_encoded.end() && iter->first == m_written; iter = m_encoded.erase(iter))
+    {
+        const std::vector<std::uint8_t>& buf { iter->second };
+
+        if (m_output.valid() && !buf.empty() && ::SDL_WriteIO(m_output.get(), buf.data(), buf.size()) != buf.size())
+            m_failed = true;
+
+        ++m_written;
+    }
+}
@@ -0,0 +1,92 @@
+#include <halcyon/video/mip_texture.hpp>
+
+#include <halcyon/debug.hpp>
+#include <halcyon/surface.hpp>
+#include <halcyon/video/renderer.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace hal;
+
+mip_texture::mip_texture(lref<const renderer> rnd, const surface& surf, resample_filter rf, bool gamma_correct)
+{
+    const std::vector<surface> mips { surf.build_mips(rf, gamma_correct) };
+
+    m_levels.reserve(mips.size() + 1);
+    m_levels.emplace_back(rnd, surf);
+
+    for (const surface& s : mips)
+        m_levels.emplace_back(rnd, s);
+}
+
+mip_texture::mip_texture(lref<const renderer> rnd, std::span<const surface> levels)
+{
+    m_levels.reserve(levels.size());
+
+    for (const surface& s : levels)
+        m_levels.emplace_back(rnd, s);
+}
+
+std::size_t mip_texture::level_for(float scale) const
+{
+    if (scale >= 1.0f || m_levels.size() < 2)
+        return 0;
+
+    // Level N is 2^N times smaller; never pick one smaller than the destination.
+    const float level { std::floor(std::log2(1.0f / scale)) };
+
+    return std::min(static_cast<std::size_t>(std::max(level, 0.0f)), m_levels.size() - 1);
+}
+
+const static_texture& mip_texture::level(std::size_t index) const
+{
+    HAL_ASSERT(index < m_levels.size(), "Mip level out of range");
+
+    return m_levels[index];
+}
+
+std::size_t mip_texture::levels() const
+{
+    return m_levels.size();
+}
+
+pixel::point mip_texture::size() const
+{
+    return m_levels.empty() ? pixel::point {} : m_levels.front().size().get_or({});
+}
+
+bool mip_texture::alpha_mod(color::value_t val)
+{
+    bool ret { true };
+
+    for (static_texture& tx : m_levels)
+        ret &= tx.alpha_mod(val);
+
+    return ret;
+}
+
+bool mip_texture::color_mod(color mod)
+{
+    bool ret { true };
+
+    for (static_texture& tx : m_levels)
+        ret &= tx.color_mod(mod);
+
+    return ret;
+}
+
+bool mip_texture::blend(blend_mode bm)
+{
+    bool ret { true };
+
+    for (static_texture& tx : m_levels)
+        ret &= tx.blend(bm);
+
+    return ret;
+}
+
+bool mip_texture::valid() const
+{
+    return !m_levels.empty() && std::ranges::all_of(m_levels, &static_texture::valid);
+}
@@ -3,14 +3,90 @@
 
 #include <halcyon/surface.hpp>
 
+#include <halcyon/video/mip_texture.hpp>
 #include <halcyon/video/texture.hpp>
 #include <halcyon/video/window.hpp>
 
 #include <halcyon/utility/guard.hpp>
 #include <halcyon/utility/strutil.hpp>
 
+#include <halcyon/internal/render_stats.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+
 using namespace hal;
 
+static_assert(sizeof(vertex) == sizeof(SDL_Vertex));
+static_assert(offsetof(vertex, color) == offsetof(SDL_Vertex, color) && offsetof(vertex, tex) == offsetof(SDL_Vertex, tex_coord));
+
+namespace
+{
+    constexpr char stats_property[] { "hal.renderer.stats" };
+
+    // Bumped whenever a renderer's statistics are destroyed, invalidating all caches.
+    std::atomic<std::uint32_t> stats_generation { 0 };
+
+    // Looking up a property on every draw call would be wasteful, so
+    // the last renderer's statistics are remembered.
+    struct stats_cache
+    {
+        SDL_Renderer*         renderer;
+        detail::render_stats* stats;
+        std::uint32_t         generation;
+    };
+
+    thread_local stats_cache cache { nullptr, nullptr, 0 };
+
+    // The bounding box of the parallelogram drawn by `copyer::affine()`.
+    coord::rect affine_bounds(coord::point origin, coord::point right, coord::point down)
+    {
+        const coord::point opposite { right + down - origin };
+
+        const coord::point tl { std::min({ origin.x, right.x, down.x, opposite.x }), std::min({ origin.y, right.y, down.y, opposite.y }) };
+        const coord::point br { std::max({ origin.x, right.x, down.x, opposite.x }), std::max({ origin.y, right.y, down.y, opposite.y }) };
+
+        return { tl, br - tl };
+    }
+
+    void destroy_stats(void*, void* value)
+    {
+        delete static_cast<detail::render_stats*>(value);
+        ++stats_generation;
+    }
+}
+
+detail::render_stats* detail::stats_of(SDL_Renderer* rnd)
+{
+    if constexpr (!compile_settings::renderer_stats)
+        return nullptr;
+
+    if (rnd == nullptr)
+        return nullptr;
+
+    const std::uint32_t gen { stats_generation.load(std::memory_order_relaxed) };
+
+    if (cache.renderer == rnd && cache.generation == gen)
+        return cache.stats;
+
+    const SDL_PropertiesID props { ::SDL_GetRendererProperties(rnd) };
+
+    auto* ret = static_cast<render_stats*>(::SDL_GetPointerProperty(props, stats_property, nullptr));
+
+    if (ret == nullptr)
+    {
+        ret = new render_stats {};
+
+        if (!::SDL_SetPointerPropertyWithCleanup(props, stats_property, ret, destroy_stats, nullptr))
+            return nullptr; // The cleanup function has already been called.
+    }
+
+    cache = { rnd, ret, gen };
+
+    return ret;
+}
+
 // ----- CREATE PROPERTIES -----
 
 using cp = renderer::create_properties;
@@ -102,7 +178,22 @@ bool renderer::clear()
 
 bool renderer::present()
 {
-    return ::SDL_RenderPresent(get());
+    if constexpr (compile_settings::renderer_stats)
+    {
+        const timer::clock::time_point start { timer::clock::now() };
+        const bool                     ret { ::SDL_RenderPresent(get()) };
+
+        if (detail::render_stats* s { detail::stats_of(get()) })
+        {
+            ++s->values.presents;
+            s->values.present_time += timer::clock::now() - start;
+        }
+
+        return ret;
+    }
+
+    else
+        return ::SDL_RenderPresent(get());
 }
 
 bool renderer::present_and_clear()
@@ -117,6 +208,7 @@ bool renderer::flush()
 
 bool renderer::draw(coord::point pt)
 {
+    detail::count_draw(get(), 1);
     return ::SDL_RenderPoint(get(), pt.x, pt.y);
 }
 
@@ -128,6 +220,7 @@ bool renderer::draw(coord::point pt, struct color c)
 
 bool renderer::draw(std::span<const coord::point> pts)
 {
+    detail::count_draw(get(), pts.size());
     return ::SDL_RenderPoints(get(), reinterpret_cast<const SDL_FPoint*>(pts.data()), static_cast<int>(pts.size()));
 }
 
@@ -139,6 +232,7 @@ bool renderer::draw(std::span<const coord::point> areas, struct color c)
 
 bool renderer::draw(coord::point from, coord::point to)
 {
+    detail::count_draw(get(), 1);
     return ::SDL_RenderLine(get(), from.x, from.y, to.x, to.y);
 }
 
@@ -150,6 +244,7 @@ bool renderer::draw(coord::point from, coord::point to, struct color c)
 
 bool renderer::draw_connected(std::span<const coord::point> pts)
 {
+    detail::count_draw(get(), pts.empty() ? 0 : pts.size() - 1);
     return ::SDL_RenderLines(get(), reinterpret_cast<const SDL_FPoint*>(pts.data()), static_cast<int>(pts.size()));
 }
 
@@ -161,6 +256,7 @@ bool renderer::draw_connected(std::span<const coord::point> areas, struct color
 
 bool renderer::draw(coord::rect area)
 {
+    detail::count_draw(get(), 1);
     return ::SDL_RenderRect(get(), area.sdl_ptr());
 }
 
@@ -172,6 +268,7 @@ bool renderer::draw(coord::rect area, struct color c)
 
 bool renderer::draw(std::span<const coord::rect> pts)
 {
+    detail::count_draw(get(), pts.size());
     return ::SDL_RenderRects(get(), reinterpret_cast<const SDL_FRect*>(pts.data()), static_cast<int>(pts.size()));
 }
 
@@ -186,8 +283,14 @@ copyer renderer::draw(ref<const texture> tx)
     return { tx, *this };
 }
 
+copyer renderer::draw(const mip_texture& mips)
+{
+    return { mips, *this };
+}
+
 bool renderer::fill(coord::rect area)
 {
+    detail::count_draw(get(), 1);
     return ::SDL_RenderFillRect(get(), area.sdl_ptr());
 }
 
@@ -199,6 +302,7 @@ bool renderer::fill(coord::rect area, struct color c)
 
 bool renderer::fill(std::span<const coord::rect> areas)
 {
+    detail::count_draw(get(), areas.size());
     return ::SDL_RenderFillRects(get(), reinterpret_cast<const SDL_FRect*>(areas.data()), static_cast<int>(areas.size()));
 }
 
@@ -210,6 +314,7 @@ bool renderer::fill(std::span<const coord::rect> areas, struct color c)
 
 bool renderer::fill()
 {
+    detail::count_draw(get(), 1);
     return ::SDL_RenderFillRect(get(), nullptr);
 }
 
@@ -219,6 +324,19 @@ bool renderer::fill(struct color c)
     return fill();
 }
 
+bool renderer::draw_geometry(ref<const texture> tx, std::span<const vertex> vertices, std::span<const int> indices)
+{
+    detail::count_copy(get(), tx.get(), (indices.empty() ? vertices.size() : indices.size()) / 3);
+
+    return ::SDL_RenderGeometry(
+        get(),
+        tx.get(),
+        reinterpret_cast<const SDL_Vertex*>(vertices.data()),
+        static_cast<int>(vertices.size()),
+        indices.empty() ? nullptr : indices.data(),
+        static_cast<int>(indices.size()));
+}
+
 bool renderer::target(ref<target_texture> tx)
 {
     return internal_target(tx.get());
@@ -263,6 +381,29 @@ bool renderer::blend(blend_mode bm)
     return ::SDL_SetRenderDrawBlendMode(get(), SDL_BlendMode(bm));
 }
 
+result<pixel::rect> renderer::viewport() const
+{
+    pixel::rect ret;
+    return { ::SDL_GetRenderViewport(get(), ret.sdl_ptr()), ret };
+}
+
+bool renderer::viewport(pixel::rect area)
+{
+    return ::SDL_SetRenderViewport(get(), area.sdl_ptr());
+}
+
+bool renderer::reset_viewport()
+{
+    return ::SDL_SetRenderViewport(get(), nullptr);
+}
+
+result<coord::rect> renderer::visible_area() const
+{
+    result<pixel::rect> vp { viewport() };
+
+    return { vp.valid(), { tag::as_size, coord::point(vp.get_or({}).size) } };
+}
+
 result<pixel::point> renderer::size() const
 {
     pixel::point ret;
@@ -315,13 +456,44 @@ rp renderer::props() const
     return { ::SDL_GetRendererProperties(get()), pass_key<renderer> {} };
 }
 
+renderer::statistics renderer::stats() const
+{
+    const detail::render_stats* s { detail::stats_of(get()) };
+
+    return s == nullptr ? statistics {} : s->values;
+}
+
+void renderer::reset_stats()
+{
+    if (detail::render_stats* s { detail::stats_of(get()) })
+        s->values = {};
+}
+
 bool renderer::internal_target(SDL_Texture* target)
 {
+    detail::count_target_switch(get(), target);
     return ::SDL_SetRenderTarget(get(), target);
 }
 
 // Copyer.
 
+copyer::copyer(const mip_texture& mips, ref<renderer> dst)
+    : drawer { mips.level(0), dst }
+    , m_mips { &mips }
+{
+}
+
+copyer& copyer::cull()
+{
+    const result<coord::rect> area { m_drawDst->visible_area() };
+
+    // Err on the side of drawing.
+    if (area.valid())
+        m_cullArea = area.get();
+
+    return *this;
+}
+
 copyer& copyer::outline()
 {
     m_drawDst->draw(m_posDst);
@@ -336,6 +508,15 @@ copyer& copyer::outline(color c)
 
 bool copyer::render()
 {
+    if (culled(m_posDst))
+        return true;
+
+    // Filling the target needs its size, which is a viewport query; only mips use it.
+    if (m_mips != nullptr)
+        select_level(m_posDst.pos.x == unset_pos() ? m_drawDst->visible_area().get_or({}).size : m_posDst.size);
+
+    detail::count_copy(m_drawDst.get(), m_drawSrc.get());
+
     return ::SDL_RenderTexture(
         m_drawDst.get(),
         m_drawSrc.get(),
@@ -345,6 +526,15 @@ bool copyer::render()
 
 bool copyer::rotated(double angle, flip f)
 {
+    if (culled(detail::rotated_bounds(m_posDst)))
+        return true;
+
+    // Filling the target needs its size, which is a viewport query; only mips use it.
+    if (m_mips != nullptr)
+        select_level(m_posDst.pos.x == unset_pos() ? m_drawDst->visible_area().get_or({}).size : m_posDst.size);
+
+    detail::count_copy(m_drawDst.get(), m_drawSrc.get());
+
     return ::SDL_RenderTextureRotated(
         m_drawDst.get(),
         m_drawSrc.get(),
@@ -357,6 +547,15 @@ bool copyer::rotated(double angle, flip f)
 
 bool copyer::affine(coord::point right, coord::point down)
 {
+    if (culled(affine_bounds(m_posDst.pos, right, down)))
+        return true;
+
+    const coord::point origin { m_posDst.pos.x == unset_pos() ? coord::point {} : m_posDst.pos };
+
+    select_level({ std::hypot(right.x - origin.x, right.y - origin.y), std::hypot(down.x - origin.x, down.y - origin.y) });
+
+    detail::count_copy(m_drawDst.get(), m_drawSrc.get());
+
     return ::SDL_RenderTextureAffine(
         m_drawDst.get(),
         m_drawSrc.get(),
@@ -368,6 +567,16 @@ bool copyer::affine(coord::point right, coord::point down)
 
 bool copyer::tiled(float scale)
 {
+    if (culled(m_posDst))
+        return true;
+
+    const coord::point tile { m_posSrc.pos.x == unset_pos() ? coord::point(m_drawSrc->size().get_or({})) : m_posSrc.size };
+
+    // Smaller levels need to be scaled up more to keep the tile size.
+    scale /= select_level(tile * scale).x;
+
+    detail::count_copy(m_drawDst.get(), m_drawSrc.get());
+
     return ::SDL_RenderTextureTiled(
         m_drawDst.get(),
         m_drawSrc.get(),
@@ -375,3 +584,34 @@ bool copyer::tiled(float scale)
         scale,
         m_posDst.pos.x == unset_pos() ? nullptr : m_posDst.sdl_ptr());
 }
+
+coord::point copyer::select_level(coord::point dst_size)
+{
+    if (m_mips == nullptr)
+        return { 1.0f, 1.0f };
+
+    const coord::point full { coord::point(m_mips->size()) };
+    const coord::point src_size { m_posSrc.pos.x == unset_pos() ? full : m_posSrc.size };
+
+    if (dst_size.x <= 0.0f || dst_size.y <= 0.0f || src_size.x <= 0.0f || src_size.y <= 0.0f)
+        return { 1.0f, 1.0f };
+
+    // The least minified axis decides, so that neither axis ends up upscaled.
+    const std::size_t lvl { m_mips->level_for(std::max(dst_size.x / src_size.x, dst_size.y / src_size.y)) };
+
+    if (lvl == 0)
+        return { 1.0f, 1.0f };
+
+    const static_texture& tx { m_mips->level(lvl) };
+    const coord::point    factor { coord::point(tx.size().get_or({})) / full };
+
+    m_drawSrc = tx;
+
+    if (m_posSrc.pos.x != unset_pos())
+    {
+        m_posSrc.pos *= factor;
+        m_posSrc.size *= factor;
+    }
+
+    return factor;
+}
@@ -0,0 +1,267 @@
+#include <halcyon/video/sprite_batch.hpp>
+
+#include <halcyon/debug.hpp>
+
+#include <cmath>
+#include <numbers>
+
+using namespace hal;
+
+namespace
+{
+    // Append two triangles per sprite.
+    void append_indices(std::vector<int>& out, std::size_t first_vertex, std::size_t sprites)
+    {
+        out.reserve(out.size() + sprites * 6);
+
+        for (std::size_t i { 0 }; i < sprites; ++i)
+        {
+            const int v { static_cast<int>(first_vertex + i * 4) };
+
+            out.insert(out.end(), { v, v + 1, v + 2, v + 2, v + 3, v });
+        }
+    }
+}
+
+sprite_batch::sprite_batch(ref<const texture> tx)
+    : m_texture { tx }
+    , m_texSize { coord::point(tx->size().get_or({ 1, 1 })) }
+    , m_cullArea {}
+    , m_cull { false }
+{
+}
+
+sprite_batch::index_t sprite_batch::add_source(pixel::rect src)
+{
+    // Stored in normalized texture coordinates.
+    m_sources.push_back({ coord::point(src.pos) / m_texSize, coord::point(src.size) / m_texSize });
+
+    return static_cast<index_t>(m_sources.size() - 1);
+}
+
+sprite_batch::index_t sprite_batch::add(coord::rect dst, index_t source)
+{
+    return add(dst, source, colors::white, 0.0f);
+}
+
+sprite_batch::index_t sprite_batch::add(coord::rect dst, index_t source, color tint, float rotation)
+{
+    HAL_ASSERT(source < m_sources.size(), "Invalid sprite source index");
+
+    m_x.push_back(dst.pos.x);
+    m_y.push_back(dst.pos.y);
+    m_w.push_back(dst.size.x);
+    m_h.push_back(dst.size.y);
+    m_source.push_back(source);
+    m_tint.push_back(tint);
+    m_rotation.push_back(rotation);
+
+    return static_cast<index_t>(m_x.size() - 1);
+}
+
+void sprite_batch::remove(index_t sprite)
+{
+    HAL_ASSERT(sprite < size(), "Invalid sprite index");
+
+    const auto swap_pop = [sprite](auto& vec)
+    {
+        vec[sprite] = vec.back();
+        vec.pop_back();
+    };
+
+    swap_pop(m_x);
+    swap_pop(m_y);
+    swap_pop(m_w);
+    swap_pop(m_h);
+    swap_pop(m_source);
+    swap_pop(m_tint);
+    swap_pop(m_rotation);
+}
+
+void sprite_batch::clear()
+{
+    m_x.clear();
+    m_y.clear();
+    m_w.clear();
+    m_h.clear();
+    m_source.clear();
+    m_tint.clear();
+    m_rotation.clear();
+}
+
+void sprite_batch::reserve(std::size_t n)
+{
+    m_x.reserve(n);
+    m_y.reserve(n);
+    m_w.reserve(n);
+    m_h.reserve(n);
+    m_source.reserve(n);
+    m_tint.reserve(n);
+    m_rotation.reserve(n);
+}
+
+std::size_t sprite_batch::size() const
+{
+    return m_x.size();
+}
+
+bool sprite_batch::empty() const
+{
+    return m_x.empty();
+}
+
+std::span<coord_t> sprite_batch::xs()
+{
+    return m_x;
+}
+
+std::span<coord_t> sprite_batch::ys()
+{
+    return m_y;
+}
+
+std::span<coord_t> sprite_batch::widths()
+{
+    return m_w;
+}
+
+std::span<coord_t> sprite_batch::heights()
+{
+    return m_h;
+}
+
+std::span<sprite_batch::index_t> sprite_batch::sources()
+{
+    return m_source;
+}
+
+std::span<color> sprite_batch::tints()
+{
+    return m_tint;
+}
+
+std::span<float> sprite_batch::rotations()
+{
+    return m_rotation;
+}
+
+std::span<const coord_t> sprite_batch::xs() const
+{
+    return m_x;
+}
+
+std::span<const coord_t> sprite_batch::ys() const
+{
+    return m_y;
+}
+
+std::span<const coord_t> sprite_batch::widths() const
+{
+    return m_w;
+}
+
+std::span<const coord_t> sprite_batch::heights() const
+{
+    return m_h;
+}
+
+std::span<const sprite_batch::index_t> sprite_batch::sources() const
+{
+    return m_source;
+}
+
+std::span<const color> sprite_batch::tints() const
+{
+    return m_tint;
+}
+
+std::span<const float> sprite_batch::rotations() const
+{
+    return m_rotation;
+}
+
+void sprite_batch::cull(coord::rect area)
+{
+    m_cullArea = area;
+    m_cull     = true;
+}
+
+void sprite_batch::reset_cull()
+{
+    m_cull = false;
+}
+
+std::size_t sprite_batch::build(std::vector<vertex>& vertices, std::vector<int>& indices) const
+{
+    const std::size_t first { vertices.size() };
+    const std::size_t ret { append_vertices(vertices) };
+
+    append_indices(indices, first, ret);
+
+    return ret;
+}
+
+bool sprite_batch::render(lref<renderer> rnd)
+{
+    m_vertices.clear();
+
+    const std::size_t n { append_vertices(m_vertices) };
+
+    if (n == 0)
+        return true;
+
+    // Indices only depend on the amount of sprites, so they're only ever extended.
+    const std::size_t have { m_indices.size() / 6 };
+
+    if (have < n)
+        append_indices(m_indices, have * 4, n - have);
+
+    return rnd->draw_geometry(m_texture, m_vertices, std::span { m_indices }.first(n * 6));
+}
+
+std::size_t sprite_batch::append_vertices(std::vector<vertex>& out) const
+{
+    constexpr float deg_to_rad { std::numbers::pi_v<float> / 180.0f };
+
+    const std::size_t old_size { out.size() };
+
+    out.reserve(old_size + size() * 4);
+
+    for (std::size_t i { 0 }; i < size(); ++i)
+    {
+        const coord::rect dst { m_x[i], m_y[i], m_w[i], m_h[i] };
+
+        if (m_cull && !((m_rotation[i] == 0.0f ? dst : detail::rotated_bounds(dst)) | m_cullArea))
+            continue;
+
+        const coord::rect& uv { m_sources[m_source[i]] };
+        const SDL_FColor   fc { vertex::to_fcolor(m_tint[i]) };
+
+        // Clockwise, starting at the top left.
+        coord::point corners[4] {
+            { dst.pos.x, dst.pos.y },
+            { dst.pos.x + dst.size.x, dst.pos.y },
+            { dst.pos.x + dst.size.x, dst.pos.y + dst.size.y },
+            { dst.pos.x, dst.pos.y + dst.size.y }
+        };
+
+        if (m_rotation[i] != 0.0f)
+        {
+            const float        s { std::sin(m_rotation[i] * deg_to_rad) }, c { std::cos(m_rotation[i] * deg_to_rad) };
+            const coord::point center { dst.pos + dst.size / 2.0f };
+
+            for (coord::point& pt : corners)
+            {
+                const coord::point d { pt - center };
+                pt = { center.x + d.x * c - d.y * s, center.y + d.x * s + d.y * c };
+            }
+        }
+
+        out.push_back({ corners[0], fc, { uv.pos.x, uv.pos.y } });
+        out.push_back({ corners[1], fc, { uv.pos.x + uv.size.x, uv.pos.y } });
+        out.push_back({ corners[2], fc, { uv.pos.x + uv.size.x, uv.pos.y + uv.size.y } });
+        out.push_back({ corners[3], fc, { uv.pos.x, uv.pos.y + uv.size.y } });
+    }
+
+    return (out.size() - old_size) / 4;
+}
@@ -3,20 +3,41 @@
 #include <halcyon/debug.hpp>
 #include <halcyon/surface.hpp>
 
+#include <halcyon/video/dirty_region.hpp>
 #include <halcyon/video/renderer.hpp>
 
+#include <halcyon/internal/render_stats.hpp>
+
+#include <cstring>
+
 using namespace hal;
 
+namespace
+{
+    // The amount of pixel data uploaded to an area of a texture (or all of it).
+    // Source rows may be much longer than the area, so their pitch doesn't matter.
+    std::size_t upload_size(const SDL_Texture* tx, const SDL_Rect* area)
+    {
+        const std::size_t w { static_cast<std::size_t>(area == nullptr ? tx->w : area->w) };
+        const std::size_t h { static_cast<std::size_t>(area == nullptr ? tx->h : area->h) };
+
+        return w * h * pixel::bytes_per_pixel_of(static_cast<pixel::format>(tx->format));
+    }
+}
+
 texture::texture(lref<const renderer> rnd, pixel::format fmt, access a, pixel::point size)
     : resource { ::SDL_CreateTexture(rnd.get(), static_cast<SDL_PixelFormat>(fmt), static_cast<SDL_TextureAccess>(a), size.x, size.y) }
 {
 }
 
+// SDL_Texture exposes its (immutable) format and size as public members, which
+// is much cheaper than going through SDL_GetTextureSize() and the property system.
+
 result<pixel::point> texture::size() const
 {
-    coord::point size;
+    const SDL_Texture* tx { get() };
 
-    return { ::SDL_GetTextureSize(get(), &size.x, &size.y), size };
+    return { tx != nullptr, tx != nullptr ? pixel::point { tx->w, tx->h } : pixel::point {} };
 }
 
 result<color::value_t> texture::alpha_mod() const
@@ -55,7 +76,9 @@ bool texture::blend(blend_mode bm)
 
 result<pixel::format> texture::pixel_format() const
 {
-    return { true, static_cast<pixel::format>(::SDL_GetNumberProperty(::SDL_GetTextureProperties(get()), "SDL_PROP_TEXTURE_FORMAT_NUMBER", 0)) };
+    const SDL_Texture* tx { get() };
+
+    return { tx != nullptr, tx != nullptr ? static_cast<pixel::format>(tx->format) : pixel::format::unknown };
 }
 
 static_texture::static_texture(lref<const renderer> rnd, pixel::point size, pixel::format fmt)
@@ -66,6 +89,8 @@ static_texture::static_texture(lref<const renderer> rnd, pixel::point size, pixe
 static_texture::static_texture(lref<const renderer> rnd, ref<const surface> surf)
     : texture { ::SDL_CreateTextureFromSurface(rnd.get(), surf.get()) }
 {
+    if (valid())
+        detail::count_upload(rnd.get(), upload_size(get(), nullptr));
 }
 
 bool static_texture::update(ref<const surface> surf, pixel::point pos)
@@ -80,8 +105,32 @@ bool static_texture::update(ref<const surface> surf, pixel::rect area)
     return internal_update(area.sdl_ptr(), surf.get()->pixels, surf.get()->pitch);
 }
 
+bool static_texture::update(ref<const surface> surf, const dirty_region& region)
+{
+    const SDL_Surface& s { *surf->get() };
+    const std::size_t  bpp { pixel::bytes_per_pixel_of(surf->pixel_format()) };
+
+    HAL_ASSERT(surf->size() == size().get(), "Surface size doesn't match the texture's");
+    HAL_ASSERT(surf->pixel_format() == pixel_format().get(), "Surface format doesn't match the texture's");
+
+    for (const pixel::rect& r : region.rects())
+    {
+        HAL_ASSERT(r.pos.x >= 0 && r.pos.y >= 0 && r.pos.x + r.size.x <= s.w && r.pos.y + r.size.y <= s.h, "Dirty area lies outside the surface");
+
+        const std::byte* pixels { static_cast<const std::byte*>(s.pixels) + r.pos.y * s.pitch + r.pos.x * bpp };
+
+        if (!internal_update(r.sdl_ptr(), pixels, s.pitch))
+            return false;
+    }
+
+    return true;
+}
+
 bool static_texture::internal_update(const SDL_Rect* area, const void* pixels, int pitch)
 {
+    if constexpr (compile_settings::renderer_stats)
+        detail::count_upload(::SDL_GetRendererFromTexture(get()), upload_size(get(), area));
+
     return ::SDL_UpdateTexture(get(), area, pixels, pitch);
 }
 
@@ -109,10 +158,48 @@ result<lock_data> streaming_texture::internal_lock(const SDL_Rect* area)
 {
     lock_data ret;
 
-    return { ::SDL_LockTexture(get(), area, reinterpret_cast<void**>(&ret.pixels), &ret.pitch), ret };
+    const bool ok { ::SDL_LockTexture(get(), area, reinterpret_cast<void**>(&ret.pixels), &ret.pitch) };
+
+    // Everything that's locked gets uploaded upon unlocking.
+    if constexpr (compile_settings::renderer_stats)
+    {
+        if (ok)
+            detail::count_upload(::SDL_GetRendererFromTexture(get()), upload_size(get(), area));
+    }
+
+    return { ok, ret };
 }
 
 void streaming_texture::unlock()
 {
     ::SDL_UnlockTexture(get());
 }
+
+bool streaming_texture::update(ref<const surface> surf, const dirty_region& region)
+{
+    const SDL_Surface& s { *surf->get() };
+    const std::size_t  bpp { pixel::bytes_per_pixel_of(surf->pixel_format()) };
+
+    HAL_ASSERT(surf->size() == size().get(), "Surface size doesn't match the texture's");
+    HAL_ASSERT(surf->pixel_format() == pixel_format().get(), "Surface format doesn't match the texture's");
+
+    for (const pixel::rect& r : region.rects())
+    {
+        HAL_ASSERT(r.pos.x >= 0 && r.pos.y >= 0 && r.pos.x + r.size.x <= s.w && r.pos.y + r.size.y <= s.h, "Dirty area lies outside the surface");
+
+        const result<lock_data> ld { lock(r) };
+
+        if (!ld.valid())
+            return false;
+
+        const std::size_t row_size { r.size.x * bpp };
+        const std::byte*  src { static_cast<const std::byte*>(s.pixels) + r.pos.y * s.pitch + r.pos.x * bpp };
+
+        for (pixel_t y { 0 }; y < r.size.y; ++y)
+            std::memcpy(ld->pixels + y * ld->pitch, src + y * s.pitch, row_size);
+
+        unlock();
+    }
+
+    return true;
+}
@@ -0,0 +1,193 @@
+#include <halcyon/video/tiled_texture.hpp>
+
+#include <halcyon/debug.hpp>
+#include <halcyon/image.hpp>
+#include <halcyon/internal/qoi.hpp>
+#include <halcyon/video/renderer.hpp>
+
+#include <algorithm>
+#include <limits>
+
+using namespace hal;
+
+namespace
+{
+    // Streamed images are decoded this many rows at a time.
+    constexpr pixel_t band_rows { 64 };
+
+    // Used if the renderer doesn't report a maximum texture size.
+    constexpr pixel_t fallback_tile_size { 2048 };
+
+    constexpr pixel::format tile_format { pixel::format::rgba32 };
+}
+
+tiled_texture::tiled_texture(lref<const renderer> rnd, accessor src, pixel_t tile_size)
+{
+    if (image::query(src) != image::load_format::qoi)
+    {
+        *this = { rnd, image::load(std::move(src)), tile_size };
+        return;
+    }
+
+    detail::qoi_decoder dec { src.get() };
+
+    if (!dec.valid() || !create(rnd, dec.size(), tile_size))
+        return;
+
+    const int                 pitch { m_size.x * 4 };
+    std::vector<std::uint8_t> band(std::size_t(pitch) * std::min(band_rows, m_size.y));
+
+    for (pixel_t y { 0 }; y < m_size.y; y += band_rows)
+    {
+        const pixel_t rows { std::min(band_rows, m_size.y - y) };
+
+        if (!dec.read(band.data(), pitch, rows) || !upload(band.data(), pitch, rows, y))
+        {
+            m_tiles.clear();
+            return;
+        }
+    }
+}
+
+tiled_texture::tiled_texture(lref<const renderer> rnd, const surface& surf, pixel_t tile_size)
+{
+    if (!surf.valid())
+        return;
+
+    if (surf.pixel_format() != tile_format || surf.must_lock())
+    {
+        *this = { rnd, surf.convert(tile_format), tile_size };
+        return;
+    }
+
+    if (create(rnd, surf.size(), tile_size) && !upload(static_cast<const std::uint8_t*>(surf->pixels), surf->pitch, m_size.y, 0))
+        m_tiles.clear();
+}
+
+bool tiled_texture::render(lref<renderer> rnd, coord::rect dst) const
+{
+    if (!valid())
+        return false;
+
+    const result<coord::rect> visible { rnd->visible_area() };
+
+    const coord::point scale { dst.size.x / m_size.x, dst.size.y / m_size.y };
+
+    bool ret { true };
+
+    for (pixel_t y { 0 }; y < m_grid.y; ++y)
+        for (pixel_t x { 0 }; x < m_grid.x; ++x)
+        {
+            const static_texture& tx { tile({ x, y }) };
+
+            const pixel::point tile_size { std::min(m_tileSize, m_size.x - x * m_tileSize), std::min(m_tileSize, m_size.y - y * m_tileSize) };
+
+            const coord::rect area {
+                dst.pos.x + x * m_tileSize * scale.x,
+                dst.pos.y + y * m_tileSize * scale.y,
+                tile_size.x * scale.x,
+                tile_size.y * scale.y
+            };
+
+            // Err on the side of drawing if the visible area is unknown.
+            if (visible.valid() && !(area | visible.get()))
+                continue;
+
+            ret &= rnd->draw(tx).to(area).render();
+        }
+
+    return ret;
+}
+
+pixel::point tiled_texture::size() const
+{
+    return m_size;
+}
+
+pixel::point tiled_texture::grid() const
+{
+    return m_grid;
+}
+
+pixel_t tiled_texture::tile_size() const
+{
+    return m_tileSize;
+}
+
+static_texture& tiled_texture::tile(pixel::point pos)
+{
+    HAL_ASSERT(pos.x >= 0 && pos.y >= 0 && pos.x < m_grid.x && pos.y < m_grid.y, "Tile position out of range");
+
+    return m_tiles[pos.y * m_grid.x + pos.x];
+}
+
+const static_texture& tiled_texture::tile(pixel::point pos) const
+{
+    HAL_ASSERT(pos.x >= 0 && pos.y >= 0 && pos.x < m_grid.x && pos.y < m_grid.y, "Tile position out of range");
+
+    return m_tiles[pos.y * m_grid.x + pos.x];
+}
+
+bool tiled_texture::valid() const
+{
+    return !m_tiles.empty();
+}
+
+bool tiled_texture::create(lref<const renderer> rnd, pixel::point size, pixel_t tile_size)
+{
+    if (tile_size <= 0)
+    {
+        const std::int64_t max { rnd->props().max_texture_size() };
+
+        tile_size = max > 0 ? static_cast<pixel_t>(std::min<std::int64_t>(max, std::numeric_limits<pixel_t>::max())) : fallback_tile_size;
+    }
+
+    m_size     = size;
+    m_tileSize = tile_size;
+    m_grid     = { (size.x + tile_size - 1) / tile_size, (size.y + tile_size - 1) / tile_size };
+
+    m_tiles.clear();
+    m_tiles.reserve(std::size_t(m_grid.x) * m_grid.y);
+
+    for (pixel_t y { 0 }; y < m_grid.y; ++y)
+        for (pixel_t x { 0 }; x < m_grid.x; ++x)
+        {
+            const pixel::point tile { std::min(tile_size, size.x - x * tile_size), std::min(tile_size, size.y - y * tile_size) };
+
+            if (!m_tiles.emplace_back(rnd, tile, tile_format).valid())
+            {
+                m_tiles.clear();
+                return false;
+            }
+        }
+
+    return true;
+}
+
+bool tiled_texture::upload(const std::uint8_t* pixels, int pitch, pixel_t rows, pixel_t first_row)
+{
+    // Rows may span multiple rows of tiles.
+    for (pixel_t r { 0 }; r < rows;)
+    {
+        const pixel_t grid_y { (first_row + r) / m_tileSize };
+        const pixel_t in_tile { (first_row + r) % m_tileSize };
+        const pixel_t count { std::min(rows - r, m_tileSize - in_tile) };
+
+        for (pixel_t x { 0 }; x < m_grid.x; ++x)
+        {
+            const pixel_t width { std::min(m_tileSize, m_size.x - x * m_tileSize) };
+
+            // A view into the rows, without copying them. SDL doesn't write through it.
+            std::uint8_t* first { const_cast<std::uint8_t*>(pixels) + std::ptrdiff_t(r) * pitch + std::ptrdiff_t(x) * m_tileSize * 4 };
+
+            const surface view { ::SDL_CreateSurfaceFrom(width, count, static_cast<SDL_PixelFormat>(tile_format), first, pitch) };
+
+            if (!view.valid() || !tile({ x, grid_y }).update(view, { 0, in_tile }))
+                return false;
+        }
+
+        r += count;
+    }
+
+    return true;
+}
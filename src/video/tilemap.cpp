@@ -0,0 +1,203 @@
+#include <halcyon/video/tilemap.hpp>
+
+#include <halcyon/debug.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace hal;
+
+tilemap::tilemap(lref<renderer> rnd, ref<const texture> tileset, pixel::point tile_size, pixel::point size, pixel_t chunk_tiles)
+    : m_renderer { rnd }
+    , m_baker { tileset }
+    , m_tiles(static_cast<std::size_t>(size.x) * static_cast<std::size_t>(size.y), empty)
+    , m_size { size }
+    , m_tileSize { tile_size }
+    , m_chunkTiles { std::max(chunk_tiles, 1) }
+    , m_tileCount { 0 }
+    , m_maxBaked { 0 }
+    , m_baked { 0 }
+    , m_frame { 0 }
+{
+    m_chunkCount = { (size.x + m_chunkTiles - 1) / m_chunkTiles, (size.y + m_chunkTiles - 1) / m_chunkTiles };
+    m_chunks.resize(static_cast<std::size_t>(m_chunkCount.x) * static_cast<std::size_t>(m_chunkCount.y));
+
+    // Every tile in the tileset becomes a sprite source, so that tile IDs are source indices.
+    const pixel::point set_size { tileset->size().get_or({}) };
+
+    for (pixel_t y { 0 }; y + tile_size.y <= set_size.y; y += tile_size.y)
+        for (pixel_t x { 0 }; x + tile_size.x <= set_size.x; x += tile_size.x)
+            m_tileCount = m_baker.add_source({ { x, y }, tile_size }) + 1;
+}
+
+tilemap::tile_t tilemap::get(pixel::point pos) const
+{
+    HAL_ASSERT(pos.x >= 0 && pos.y >= 0 && pos.x < m_size.x && pos.y < m_size.y, "Tile position out of bounds");
+
+    return m_tiles[static_cast<std::size_t>(pos.y) * m_size.x + pos.x];
+}
+
+void tilemap::set(pixel::point pos, tile_t tile)
+{
+    HAL_ASSERT(pos.x >= 0 && pos.y >= 0 && pos.x < m_size.x && pos.y < m_size.y, "Tile position out of bounds");
+
+    tile_t& t { m_tiles[static_cast<std::size_t>(pos.y) * m_size.x + pos.x] };
+
+    if (t == tile)
+        return;
+
+    t = tile;
+
+    chunk& c { chunk_at({ pos.x / m_chunkTiles, pos.y / m_chunkTiles }) };
+
+    if (c.layer.has_value())
+        c.layer->invalidate();
+}
+
+void tilemap::assign(std::span<const tile_t> tiles)
+{
+    HAL_ASSERT(tiles.size() == m_tiles.size(), "Tile count mismatch");
+
+    std::ranges::copy(tiles, m_tiles.begin());
+    invalidate();
+}
+
+bool tilemap::render(coord::rect view)
+{
+    ++m_frame;
+
+    const coord::point chunk_px { coord::point(m_tileSize * m_chunkTiles) };
+
+    // The range of chunks the view overlaps, clamped to the map.
+    const pixel_t x0 { std::max(static_cast<pixel_t>(std::floor(view.pos.x / chunk_px.x)), 0) };
+    const pixel_t y0 { std::max(static_cast<pixel_t>(std::floor(view.pos.y / chunk_px.y)), 0) };
+    const pixel_t x1 { std::min(static_cast<pixel_t>(std::ceil((view.pos.x + view.size.x) / chunk_px.x)), m_chunkCount.x) };
+    const pixel_t y1 { std::min(static_cast<pixel_t>(std::ceil((view.pos.y + view.size.y) / chunk_px.y)), m_chunkCount.y) };
+
+    bool ret { true };
+
+    for (pixel_t y { y0 }; y < y1; ++y)
+    {
+        for (pixel_t x { x0 }; x < x1; ++x)
+        {
+            chunk& c { chunk_at({ x, y }) };
+
+            if (!c.layer.has_value())
+            {
+                evict();
+
+                c.layer.emplace(m_renderer, m_tileSize * m_chunkTiles);
+                ++m_baked;
+            }
+
+            c.last_used = m_frame;
+
+            bool baked { true };
+
+            ret &= c.layer->update([&](renderer& rnd)
+                { baked = bake(rnd, { x, y }); });
+
+            // A chunk that failed to bake has undefined contents; try again next time.
+            if (!baked)
+            {
+                c.layer->invalidate();
+                ret = false;
+
+                continue;
+            }
+
+            ret &= c.layer->draw().to(coord::point { x * chunk_px.x, y * chunk_px.y } - view.pos).render();
+        }
+    }
+
+    return ret;
+}
+
+void tilemap::max_baked_chunks(std::size_t n)
+{
+    m_maxBaked = n;
+}
+
+std::size_t tilemap::max_baked_chunks() const
+{
+    return m_maxBaked;
+}
+
+std::size_t tilemap::baked_chunks() const
+{
+    return m_baked;
+}
+
+void tilemap::invalidate()
+{
+    for (chunk& c : m_chunks)
+        c.layer.reset();
+
+    m_baked = 0;
+}
+
+pixel::point tilemap::size() const
+{
+    return m_size;
+}
+
+pixel::point tilemap::tile_size() const
+{
+    return m_tileSize;
+}
+
+tilemap::chunk& tilemap::chunk_at(pixel::point chunk_pos)
+{
+    return m_chunks[static_cast<std::size_t>(chunk_pos.y) * m_chunkCount.x + chunk_pos.x];
+}
+
+bool tilemap::bake(renderer& rnd, pixel::point chunk_pos)
+{
+    const pixel::point first { chunk_pos * m_chunkTiles };
+    const pixel::point last { std::min(first.x + m_chunkTiles, m_size.x), std::min(first.y + m_chunkTiles, m_size.y) };
+
+    m_baker.clear();
+
+    for (pixel_t y { first.y }; y < last.y; ++y)
+    {
+        for (pixel_t x { first.x }; x < last.x; ++x)
+        {
+            const tile_t t { m_tiles[static_cast<std::size_t>(y) * m_size.x + x] };
+
+            if (t == empty)
+                continue;
+
+            HAL_ASSERT(t < m_tileCount, "Tile ID exceeds the tileset");
+
+            const coord::point pos { coord::point((pixel::point { x, y } - first) * m_tileSize) };
+
+            m_baker.add({ pos, coord::point(m_tileSize) }, t);
+        }
+    }
+
+    return m_baker.render(rnd);
+}
+
+void tilemap::evict()
+{
+    if (m_maxBaked == 0)
+        return;
+
+    while (m_baked >= m_maxBaked)
+    {
+        chunk* oldest { nullptr };
+
+        for (chunk& c : m_chunks)
+        {
+            // Chunks drawn this frame are still needed.
+            if (c.layer.has_value() && c.last_used != m_frame && (oldest == nullptr || c.last_used < oldest->last_used))
+                oldest = &c;
+        }
+
+        if (oldest == nullptr)
+            return;
+
+        oldest->layer.reset();
+        --m_baked;
+    }
+}
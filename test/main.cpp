@@ -3,10 +3,13 @@
 #include <halcyon/filesystem.hpp>
 #include <halcyon/image.hpp>
 #include <halcyon/subsystem.hpp>
+#include <halcyon/types/batch.hpp>
 #include <halcyon/ttf.hpp>
 
 #include <halcyon/utility/guard.hpp>
 #include <halcyon/utility/shared.hpp>
+#include <halcyon/utility/spatial_index.hpp>
+#include <halcyon/utility/thread_pool.hpp>
 
 #include <halcyon/main.hpp>
 
@@ -347,6 +350,1137 @@ namespace
         hal::text t { f, "ligma" };
         t.size().get();
 
+        // Laying out the whole charset fills the engine's atlas for the font.
+        FAIL_IF(s.warm_up(f, hal::ttf::charset::ascii()) == 0, "Could not warm up the text engine");
+
+        return EXIT_SUCCESS;
+    }
+
+    // Merging and clipping of changed areas.
+    int dirty_region()
+    {
+        hal::dirty_region dr { { 64, 64 } };
+
+        dr.add({ 0, 0, 8, 8 });
+        dr.add({ 8, 0, 8, 8 });
+
+        FAIL_IF(dr.rects().size() != 1, "Adjacent areas not merged (", dr.rects().size(), " rects)");
+        FAIL_IF(dr.rects().front() != hal::pixel::rect(0, 0, 16, 8), "Merged area mismatch (actual ", dr.rects().front(), ')');
+
+        dr.add({ 40, 40, 4, 4 });
+
+        FAIL_IF(dr.rects().size() != 2, "Distant areas merged when they shouldn't be");
+
+        dr.add({ 60, 60, 16, 16 });
+
+        FAIL_IF(dr.area() != 16 * 8 + 4 * 4 + 4 * 4, "Area not clipped to bounds (area ", dr.area(), ')');
+
+        dr.policy({ .max_rects = 1, .max_waste = 0.0f });
+
+        FAIL_IF(dr.rects().size() != 1, "Rectangle limit not enforced");
+        FAIL_IF(dr.extent() != hal::pixel::rect(0, 0, 64, 64), "Extent mismatch (actual ", dr.extent(), ')');
+
+        dr.clear();
+
+        FAIL_IF(!dr.empty(), "Region not empty after clearing");
+
+        return EXIT_SUCCESS;
+    }
+
+    // Recording commands out of order and checking whether layering is preserved.
+    int command_buffer()
+    {
+        hal::cleanup_init<hal::subsystem::video> vid;
+
+        hal::window   wnd { vid, "HalTest: Command buffer", { 640, 480 }, hal::window::flag::hidden };
+        hal::renderer rnd { wnd };
+
+        hal::target_texture tex { rnd, { 4, 4 }, hal::pixel::format::rgba32 };
+        hal::command_buffer buf { rnd };
+
+        buf.target(tex);
+
+        buf.layer(1);
+        buf.fill({ 0, 0, 2, 2 }, hal::colors::blue);
+
+        buf.layer(0);
+        buf.fill({ 0, 0, 4, 4 }, hal::colors::red);
+
+        FAIL_IF(!buf.submit(), "Could not submit command buffer");
+
+        hal::guard::target _ { rnd, tex };
+
+        const hal::surface s { rnd.read_pixels() };
+
+        FAIL_IF(s.pixel({ 0, 0 }).get() != hal::colors::blue, "Upper layer overwritten by lower layer");
+        FAIL_IF(s.pixel({ 3, 3 }).get() != hal::colors::red, "Lower layer not drawn");
+
+        return EXIT_SUCCESS;
+    }
+
+    // Running tasks on a thread pool and merging parallel command lists.
+    int thread_pool()
+    {
+        constexpr std::size_t n { 1000 };
+
+        hal::thread_pool pool { 4 };
+
+        std::atomic<std::size_t> sum { 0 };
+
+        pool.for_each(n, [&](std::size_t i)
+            { sum += i; });
+
+        FAIL_IF(sum != n * (n - 1) / 2, "Parallel sum mismatch (actual ", sum.load(), ')');
+
+        auto fut = pool.submit([]
+            { return 42; });
+
+        FAIL_IF(fut.get() != 42, "Task result mismatch");
+
+        // Exceptions reach the caller only after every helper has let go of the loop.
+        bool thrown { false };
+
+        try
+        {
+            pool.for_each(n, [](std::size_t i)
+                { if (i == n / 2) throw std::runtime_error { "for_each" }; });
+        }
+
+        catch (const std::runtime_error&)
+        {
+            thrown = true;
+        }
+
+        FAIL_IF(!thrown, "Exception not rethrown from for_each()");
+
+        hal::cleanup_init<hal::subsystem::video> vid;
+
+        hal::window   wnd { vid, "HalTest: Thread pool", { 640, 480 }, hal::window::flag::hidden };
+        hal::renderer rnd { wnd };
+
+        std::array bufs { hal::command_buffer { rnd }, hal::command_buffer { rnd }, hal::command_buffer { rnd }, hal::command_buffer { rnd } };
+
+        hal::record_parallel(pool, std::span { bufs }, [](hal::command_buffer& buf, std::size_t i)
+            {
+                buf.layer(static_cast<hal::command_buffer::layer_t>(4 - i));
+                buf.fill({ 0, 0, 1, 1 }); });
+
+        hal::command_buffer merged { rnd };
+
+        for (const hal::command_buffer& buf : bufs)
+            merged.merge(buf);
+
+        FAIL_IF(merged.size() != bufs.size(), "Merged buffer size mismatch");
+        FAIL_IF(!std::ranges::is_sorted(merged.commands(), {}, &hal::command_buffer::command::layer), "Merged commands not sorted by layer");
+
+        return EXIT_SUCCESS;
+    }
+
+    // Blitting and scaling in parallel bands.
+    int parallel_blit()
+    {
+        hal::thread_pool pool { 3 };
+
+        hal::surface src { { 256, 256 } };
+
+        for (int y { 0 }; y < 16; ++y)
+            for (int x { 0 }; x < 16; ++x)
+                src.fill({ x * 16, y * 16, 16, 16 }, hal::color(static_cast<hal::color::value_t>(x * 16), static_cast<hal::color::value_t>(y * 16), static_cast<hal::color::value_t>((x ^ y) * 16)));
+
+        const auto same_pixels = [](const hal::surface& a, const hal::surface& b)
+        {
+            if (a.size() != b.size())
+                return false;
+
+            for (int y { 0 }; y < a->h; ++y)
+            {
+                const auto* row_a = static_cast<const Uint8*>(a->pixels) + y * a->pitch;
+                const auto* row_b = static_cast<const Uint8*>(b->pixels) + y * b->pitch;
+
+                if (!std::equal(row_a, row_a + a->w * 4, row_b))
+                    return false;
+            }
+
+            return true;
+        };
+
+        // An integer scale factor, so that bands match a single blit exactly.
+        const hal::surface serial { src.resize({ 512, 512 }) };
+        const hal::surface parallel { src.resize({ 512, 512 }, hal::surface::default_scale_mode(), pool) };
+
+        FAIL_IF(!same_pixels(serial, parallel), "Parallel scaling differs from serial scaling");
+
+        hal::surface blit_serial { { 300, 300 } }, blit_parallel { { 300, 300 } };
+
+        FAIL_IF(!src.blit(blit_serial).to(hal::pixel::point { 10, 20 }).blit(), "Could not blit");
+        FAIL_IF(!src.blit(blit_parallel).to(hal::pixel::point { 10, 20 }).blit(pool), "Could not blit in parallel");
+
+        FAIL_IF(!same_pixels(blit_serial, blit_parallel), "Parallel blit differs from serial blit");
+
+        return EXIT_SUCCESS;
+    }
+
+    // Filtered resizing, in both gamma and linear light.
+    int resample()
+    {
+        constexpr hal::color flat_color { 100, 150, 200 };
+
+        hal::surface flat { { 64, 64 } };
+        flat.fill(flat_color);
+
+        // Normalized weights must keep a flat color exactly as it is.
+        for (hal::resample_filter rf : { hal::resample_filter::bilinear, hal::resample_filter::bicubic, hal::resample_filter::lanczos3 })
+        {
+            for (bool gamma_correct : { false, true })
+            {
+                const hal::surface s { flat.resize({ 23, 100 }, rf, gamma_correct) };
+
+                FAIL_IF((s.size() != hal::pixel::point { 23, 100 }), "Resampled size mismatch");
+                FAIL_IF(s.pixel({ 0, 0 }).get() != flat_color || s.pixel({ 11, 57 }).get() != flat_color, "Flat color changed by ", hal::to_string(rf));
+            }
+        }
+
+        // A black-and-white checkerboard averages to mid-gray, which is brighter in linear light.
+        hal::surface checker { { 32, 32 } };
+        checker.fill(hal::colors::black);
+
+        for (int y { 0 }; y < 32; ++y)
+            for (int x { y % 2 }; x < 32; x += 2)
+                checker.pixel({ x, y }, hal::colors::white);
+
+        const hal::color gamma { checker.resize({ 16, 16 }, hal::resample_filter::bilinear).pixel({ 8, 8 }).get() };
+        const hal::color linear { checker.resize({ 16, 16 }, hal::resample_filter::bilinear, true).pixel({ 8, 8 }).get() };
+
+        FAIL_IF(gamma.r < 126 || gamma.r > 130, "Checkerboard average mismatch (actual ", int(gamma.r), ')');
+        FAIL_IF(linear.r < 185 || linear.r > 190, "Gamma-correct checkerboard average mismatch (actual ", int(linear.r), ')');
+
+        return EXIT_SUCCESS;
+    }
+
+    // Building mipmap chains and drawing from the fitting level.
+    int mip_texture()
+    {
+        hal::surface base { { 64, 32 } };
+        base.fill(hal::colors::red);
+
+        const std::vector<hal::surface> mips { base.build_mips(hal::resample_filter::kaiser) };
+
+        FAIL_IF(mips.size() != 6, "Mip count mismatch (actual ", mips.size(), ')');
+        FAIL_IF((mips.front().size() != hal::pixel::point { 32, 16 }), "First mip size mismatch");
+        FAIL_IF((mips.back().size() != hal::pixel::point { 1, 1 }), "Last mip size mismatch");
+        FAIL_IF(mips.back().pixel({ 0, 0 }).get() != hal::colors::red, "Mip color mismatch");
+
+        hal::cleanup_init<hal::subsystem::video> vid;
+
+        hal::window   wnd { vid, "HalTest: Mip texture", { 640, 480 }, hal::window::flag::hidden };
+        hal::renderer rnd { wnd };
+
+        // Every level gets a different color, to tell which one was drawn.
+        std::array<hal::surface, 3> levels { hal::surface { { 64, 64 } }, hal::surface { { 32, 32 } }, hal::surface { { 16, 16 } } };
+        levels[0].fill(hal::colors::red);
+        levels[1].fill(hal::colors::green);
+        levels[2].fill(hal::colors::blue);
+
+        const hal::mip_texture tex { rnd, levels };
+
+        FAIL_IF(!tex.valid() || tex.levels() != 3, "Mip texture not uploaded");
+        FAIL_IF(tex.level_for(1.0f) != 0 || tex.level_for(0.6f) != 0 || tex.level_for(0.5f) != 1 || tex.level_for(0.01f) != 2, "Mip level selection mismatch");
+
+        hal::target_texture target { rnd, { 64, 64 }, hal::pixel::format::rgba32 };
+        hal::guard::target  _ { rnd, target };
+
+        FAIL_IF(!rnd.draw(tex).to({ 0.0f, 0.0f, 40.0f, 40.0f }).render(), "Could not draw mip texture");
+        FAIL_IF(!rnd.draw(tex).to({ 40.0f, 0.0f, 20.0f, 20.0f }).render(), "Could not draw mip texture");
+        FAIL_IF(!rnd.draw(tex).to({ 40.0f, 40.0f, 10.0f, 10.0f }).render(), "Could not draw mip texture");
+
+        const hal::surface s { rnd.read_pixels() };
+
+        FAIL_IF(s.pixel({ 20, 20 }).get() != hal::colors::red, "Wrong level for a slight downscale");
+        FAIL_IF(s.pixel({ 50, 10 }).get() != hal::colors::green, "Wrong level for a 1/2 downscale");
+        FAIL_IF(s.pixel({ 45, 45 }).get() != hal::colors::blue, "Wrong level for a heavy downscale");
+
+        return EXIT_SUCCESS;
+    }
+
+    // Specialized format conversions must match SDL's own, byte for byte.
+    int fast_convert()
+    {
+        constexpr std::array pairs {
+            std::pair { hal::pixel::format::rgba32, hal::pixel::format::argb8888 },
+            std::pair { hal::pixel::format::argb8888, hal::pixel::format::rgba32 },
+            std::pair { hal::pixel::format::rgb24, hal::pixel::format::rgba32 },
+            std::pair { hal::pixel::format::rgba32, hal::pixel::format::rgb565 },
+            std::pair { hal::pixel::format::index8, hal::pixel::format::rgba32 }
+        };
+
+        for (const auto& [from, to] : pairs)
+        {
+            // An odd width leaves pixels for the scalar tails of vectorized kernels.
+            hal::surface src { { 37, 5 }, from };
+
+            SDL_Surface& raw { *src.get() };
+
+            if (from == hal::pixel::format::index8)
+            {
+                std::array<SDL_Color, 256> colors;
+
+                for (std::size_t i { 0 }; i < colors.size(); ++i)
+                    colors[i] = { Uint8(i), Uint8(i * 7), Uint8(255 - i), Uint8(i * 3) };
+
+                SDL_Palette* pal { ::SDL_CreateSurfacePalette(&raw) };
+                FAIL_IF(pal == nullptr || !::SDL_SetPaletteColors(pal, colors.data(), 0, int(colors.size())), "Could not set palette");
+            }
+
+            for (int y { 0 }; y < raw.h; ++y)
+            {
+                Uint8* row { static_cast<Uint8*>(raw.pixels) + y * raw.pitch };
+
+                for (int x { 0 }; x < raw.pitch; ++x)
+                    row[x] = Uint8(x * 31 + y * 17);
+            }
+
+            const hal::surface fast { src.convert(to) };
+            const hal::surface reference { ::SDL_ConvertSurface(&raw, static_cast<SDL_PixelFormat>(to)) };
+
+            FAIL_IF(!fast.valid() || !reference.valid(), "Conversion to ", hal::to_string(to), " failed");
+            FAIL_IF(fast.pixel_format() != to, "Converted format mismatch");
+
+            const SDL_Surface& a { *fast.get() };
+            const SDL_Surface& b { *reference.get() };
+
+            const std::size_t row_size { std::size_t(a.w) * SDL_BYTESPERPIXEL(a.format) };
+
+            for (int y { 0 }; y < a.h; ++y)
+            {
+                FAIL_IF(std::memcmp(static_cast<const Uint8*>(a.pixels) + y * a.pitch, static_cast<const Uint8*>(b.pixels) + y * b.pitch, row_size) != 0,
+                    "Pixel mismatch converting ", hal::to_string(from), " to ", hal::to_string(to), " in row ", y);
+            }
+
+            SDL_BlendMode fast_bm, reference_bm;
+            ::SDL_GetSurfaceBlendMode(fast.get(), &fast_bm);
+            ::SDL_GetSurfaceBlendMode(reference.get(), &reference_bm);
+
+            FAIL_IF(fast_bm != reference_bm, "Blend mode mismatch converting ", hal::to_string(from), " to ", hal::to_string(to));
+        }
+
+        return EXIT_SUCCESS;
+    }
+
+    // Staged captures that are read back a few frames later.
+    int capture_queue()
+    {
+        hal::cleanup_init<hal::subsystem::video> vid;
+
+        hal::window   wnd { vid, "HalTest: Capture queue", { 640, 480 }, hal::window::flag::hidden };
+        hal::renderer rnd { wnd };
+
+        hal::target_texture tex { rnd, { 16, 8 }, hal::pixel::format::rgba32 };
+
+        {
+            hal::guard::target _ { rnd, tex };
+            hal::guard::color  __ { rnd, hal::colors::red };
+            rnd.clear();
+        }
+
+        hal::thread_pool   pool { 2 };
+        hal::capture_queue queue { rnd, pool, 2 };
+        std::atomic<bool>  handled { false };
+
+        const hal::capture_queue::ticket polled { queue.capture(tex) };
+        const hal::capture_queue::ticket pushed { queue.capture(tex, [&](hal::surface s)
+            { handled = s.valid() && s.pixel({ 15, 7 }).get() == hal::colors::red; }) };
+
+        // Later changes must not show up in captures made before them.
+        {
+            hal::guard::target _ { rnd, tex };
+            hal::guard::color  __ { rnd, hal::colors::blue };
+            rnd.clear();
+        }
+
+        FAIL_IF(pushed == polled, "Capture tickets not unique");
+        FAIL_IF(queue.pending() != 2, "Captures not staged");
+        FAIL_IF(queue.take(polled).valid(), "Capture read back too early");
+
+        FAIL_IF(queue.update() != 0, "Capture read back before its delay");
+        FAIL_IF(queue.update() != 2, "Captures not read back after their delay");
+
+        const hal::surface s { queue.take(polled) };
+
+        FAIL_IF(!s.valid() || (s.size() != hal::pixel::point { 16, 8 }), "Captured surface mismatch");
+        FAIL_IF(s.pixel({ 0, 0 }).get() != hal::colors::red, "Captured pixels mismatch");
+        FAIL_IF(queue.take(polled).valid(), "Capture taken twice");
+
+        pool.wait();
+
+        FAIL_IF(!handled, "Capture handler not run on the pool");
+
+        return EXIT_SUCCESS;
+    }
+
+    // Recording frames in order, encoded on a pool.
+    int frame_recorder()
+    {
+        hal::cleanup_init<hal::subsystem::video> vid;
+
+        hal::window   wnd { vid, "HalTest: Frame recorder", { 640, 480 }, hal::window::flag::hidden };
+        hal::renderer rnd { wnd };
+
+        hal::target_texture tex { rnd, { 6, 4 }, hal::pixel::format::rgba32 };
+        hal::guard::target  _ { rnd, tex };
+
+        hal::thread_pool pool { 2 };
+
+        constexpr std::array  frame_colors { hal::colors::red, hal::colors::green, hal::colors::blue };
+        constexpr std::size_t frame_size { 6 * 4 * 4 };
+
+        std::vector<std::byte> raw(frame_size * frame_colors.size());
+
+        {
+            // Fewer surfaces than frames, so that some get reused.
+            hal::frame_recorder rec { rnd, hal::as_bytes(raw), pool, hal::frame_recorder::format::rgba, 2 };
+
+            for (const hal::color c : frame_colors)
+            {
+                hal::guard::color __ { rnd, c };
+                rnd.clear();
+
+                FAIL_IF(!rec.record(), "Could not record frame");
+                rec.update();
+            }
+
+            FAIL_IF(!rec.finish(), "Could not write recorded frames");
+            FAIL_IF(rec.frames() != frame_colors.size(), "Recorded frame count mismatch (actual ", rec.frames(), ')');
+            FAIL_IF((rec.size() != hal::pixel::point { 6, 4 }), "Recorded frame size mismatch");
+        }
+
+        for (std::size_t i { 0 }; i < frame_colors.size(); ++i)
+        {
+            const hal::color c { frame_colors[i] };
+
+            for (std::size_t offset : { i * frame_size, (i + 1) * frame_size - 4 })
+            {
+                FAIL_IF(raw[offset] != std::byte(c.r) || raw[offset + 1] != std::byte(c.g) || raw[offset + 2] != std::byte(c.b) || raw[offset + 3] != std::byte(0xFF),
+                    "Frame ", i, " recorded out of order or with the wrong color");
+            }
+        }
+
+        std::vector<std::byte> qoi(1024);
+
+        {
+            hal::frame_recorder rec { rnd, hal::as_bytes(qoi), pool };
+
+            FAIL_IF(!rec.record() || !rec.finish(), "Could not record QOI frame");
+        }
+
+        const hal::surface decoded { hal::image::load(hal::as_bytes(std::as_const(qoi)), hal::image::load_format::qoi) };
+
+        FAIL_IF(!decoded.valid(), "Could not decode recorded QOI frame");
+        FAIL_IF(decoded.pixel({ 5, 3 }).get() != hal::colors::blue, "Decoded QOI frame mismatch");
+
+        return EXIT_SUCCESS;
+    }
+
+    // Encoding QOI images in parallel strips, which must decode like any other.
+    int parallel_qoi()
+    {
+        hal::surface src { { 97, 300 } };
+
+        // Gradients, flat areas and translucency exercise every kind of QOI op.
+        for (int y { 0 }; y < 300; ++y)
+            for (int x { 0 }; x < 97; ++x)
+            {
+                const hal::color c { x < 40 ? hal::color { Uint8(x * 3), Uint8(y), Uint8(x ^ y), Uint8(y < 150 ? 255 : x + y) } : hal::colors::cyan };
+                src.pixel({ x, y }, c);
+            }
+
+        hal::thread_pool pool { 3 };
+
+        std::vector<std::byte> serial(128 * 1024), parallel(128 * 1024);
+
+        FAIL_IF(!hal::image::save::qoi(src, hal::as_bytes(serial)), "Could not encode QOI image");
+        FAIL_IF(!hal::image::save::qoi(src, hal::as_bytes(parallel), pool), "Could not encode QOI image in parallel");
+
+        for (const std::vector<std::byte>* buf : { &serial, &parallel })
+        {
+            const hal::surface decoded { hal::image::load(hal::as_bytes(*buf), hal::image::load_format::qoi) };
+
+            FAIL_IF(!decoded.valid() || decoded.size() != src.size(), "Could not decode QOI image");
+
+            for (int y { 0 }; y < 300; ++y)
+                for (int x { 0 }; x < 97; ++x)
+                    FAIL_IF(decoded.pixel({ x, y }).get() != src.pixel({ x, y }).get(), "Decoded QOI pixel mismatch at ", x, ", ", y);
+        }
+
+        return EXIT_SUCCESS;
+    }
+
+    // Decoding images straight into a grid of textures.
+    int tiled_texture()
+    {
+        hal::surface src { { 300, 200 } };
+
+        for (int y { 0 }; y < 200; ++y)
+            for (int x { 0 }; x < 300; ++x)
+                src.pixel({ x, y }, hal::color { Uint8(x), Uint8(y), Uint8(x / 128 + y / 128 * 3) });
+
+        std::vector<std::byte> qoi(256 * 1024), bmp(256 * 1024);
+
+        FAIL_IF(!hal::image::save::qoi(src, hal::as_bytes(qoi)), "Could not encode QOI image");
+        FAIL_IF(!src.save(hal::as_bytes(bmp)), "Could not encode BMP image");
+
+        hal::cleanup_init<hal::subsystem::video> vid;
+
+        hal::window   wnd { vid, "HalTest: Tiled texture", { 640, 480 }, hal::window::flag::hidden };
+        hal::renderer rnd { wnd };
+
+        hal::target_texture target { rnd, { 300, 200 }, hal::pixel::format::rgba32 };
+        hal::guard::target  _ { rnd, target };
+
+        // QOI images are streamed; other formats are loaded whole, then split.
+        for (const std::vector<std::byte>* buf : { &qoi, &bmp })
+        {
+            const hal::tiled_texture tex { rnd, hal::as_bytes(*buf), 128 };
+
+            FAIL_IF(!tex.valid(), "Could not load tiled texture");
+            FAIL_IF((tex.size() != hal::pixel::point { 300, 200 }), "Tiled texture size mismatch");
+            FAIL_IF((tex.grid() != hal::pixel::point { 3, 2 }), "Tile grid mismatch");
+            FAIL_IF((tex.tile({ 2, 1 }).size().get() != hal::pixel::point { 44, 72 }), "Edge tile size mismatch");
+
+            rnd.clear();
+            FAIL_IF(!tex.render(rnd, { 0.0f, 0.0f, 300.0f, 200.0f }), "Could not render tiled texture");
+
+            const hal::surface s { rnd.read_pixels() };
+
+            for (const hal::pixel::point pt : { hal::pixel::point { 0, 0 }, hal::pixel::point { 127, 127 }, hal::pixel::point { 128, 128 }, hal::pixel::point { 299, 199 }, hal::pixel::point { 200, 50 } })
+                FAIL_IF(s.pixel(pt).get() != src.pixel(pt).get(), "Tiled texture pixel mismatch at ", pt.x, ", ", pt.y);
+        }
+
+        return EXIT_SUCCESS;
+    }
+
+    // Recognizing formats by their signatures, and loading without knowing them.
+    int image_sniff()
+    {
+        using enum hal::image::load_format;
+
+        hal::surface src { { 5, 3 } };
+        src.fill(hal::colors::green);
+
+        std::vector<std::byte> qoi_buf(1024), bmp_buf(1024);
+
+        FAIL_IF(!hal::image::save::qoi(src, hal::as_bytes(qoi_buf)), "Could not encode QOI image");
+        FAIL_IF(!src.save(hal::as_bytes(bmp_buf)), "Could not encode BMP image");
+
+        const std::vector<std::byte> &qoi_data { qoi_buf }, &bmp_data { bmp_buf };
+
+        FAIL_IF(hal::image::query(hal::as_bytes(test::png_2x1)) != png, "PNG data not recognized");
+        FAIL_IF(hal::image::query(hal::as_bytes(qoi_data)) != qoi, "QOI data not recognized");
+        FAIL_IF(hal::image::query(hal::as_bytes(bmp_data)) != bmp, "BMP data not recognized");
+
+        // An uncompressed TGA header starts like a cursor, but with no images in it.
+        constexpr std::array<std::uint8_t, 18> tga { 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 1, 0, 32, 8 };
+        constexpr std::string_view              text { "Not an image at all" };
+
+        FAIL_IF(hal::image::query(hal::as_bytes(tga)) == cur, "TGA data mistaken for a cursor");
+        FAIL_IF(hal::image::query(hal::as_bytes(text)) != unknown, "Text recognized as an image");
+
+        for (const std::vector<std::byte>* buf : { &qoi_data, &bmp_data })
+        {
+            const hal::surface s { hal::image::load(hal::as_bytes(*buf)) };
+
+            FAIL_IF(!s.valid(), "Could not load sniffed image");
+            FAIL_IF((s.size() != hal::pixel::point { 5, 3 }), "Sniffed image size mismatch");
+            FAIL_IF(s.pixel({ 4, 2 }).get() != hal::colors::green, "Sniffed image color mismatch");
+        }
+
+        FAIL_IF(hal::image::load(hal::as_bytes(text)).valid(), "Text loaded as an image");
+
+        return EXIT_SUCCESS;
+    }
+
+    // Making fonts of several sizes from one loaded face.
+    int font_face()
+    {
+        hal::ttf::context        ctx;
+        hal::fs::resource_loader rl;
+
+        hal::font small, large;
+
+        {
+            const hal::font_face face { rl.access("assets/m5x7.ttf") };
+
+            FAIL_IF(!face.valid() || face.size() == 0, "Could not load font face");
+
+            small = ctx.make_font(face, 16);
+            large = ctx.make_font(face, 48);
+        }
+
+        // The fonts keep the face's data alive on their own.
+        FAIL_IF(!small.valid() || !large.valid(), "Could not make fonts from face");
+        FAIL_IF(small.height() >= large.height(), "Font sizes not applied");
+        FAIL_IF(!small.render_blended("Shared", hal::colors::white).valid(), "Could not render with shared face");
+
+        FAIL_IF(!small.size(48), "Could not resize font");
+        FAIL_IF(small.size() != 48, "Font size mismatch (actual ", int(small.size()), ')');
+        FAIL_IF(small.height() != large.height(), "Resized font height mismatch");
+
+        return EXIT_SUCCESS;
+    }
+
+    // Resolving distance field text at several scales.
+    int sdf_text()
+    {
+        hal::ttf::context        ctx;
+        hal::fs::resource_loader rl;
+
+        hal::font f { ctx.make_font(rl.access("assets/m5x7.ttf"), 32) };
+
+        FAIL_IF(!f.sdf(true) || !f.sdf(), "Could not enable SDF rendering");
+
+        const hal::sdf_text::style st {
+            .fill          = hal::colors::white,
+            .outline       = hal::colors::red,
+            .outline_width = 2.0f
+        };
+
+        const hal::sdf_text txt { f, "SDF", st };
+
+        FAIL_IF(!txt.valid(), "Could not render SDF text");
+
+        for (const float scale : { 1.0f, 2.0f, 3.5f })
+        {
+            const hal::surface s { txt.resolve(scale) };
+
+            FAIL_IF(!s.valid(), "Could not resolve SDF text at scale ", scale);
+            FAIL_IF(s.size() != txt.size(scale), "Resolved size mismatch at scale ", scale);
+
+            bool fill { false }, outline { false }, empty { false };
+
+            for (hal::pixel_t y { 0 }; y < s.size().y; ++y)
+                for (hal::pixel_t x { 0 }; x < s.size().x; ++x)
+                {
+                    const hal::color c { s.pixel({ x, y }).get() };
+
+                    fill |= c == hal::colors::white;
+                    outline |= c == hal::colors::red;
+                    empty |= c.a == hal::color::transparent;
+                }
+
+            FAIL_IF(!fill || !outline || !empty, "Missing fill, outline or background at scale ", scale);
+        }
+
+        hal::cleanup_init<hal::subsystem::video> vid;
+
+        hal::window   wnd { vid, "HalTest: SDF text", { 640, 480 }, hal::window::flag::hidden };
+        hal::renderer rnd { wnd };
+
+        // An animated scale keeps resolving into the same couple of textures, growing and shrinking.
+        hal::sdf_text animated { f, "SDF", st, 2 };
+
+        for (int i { 0 }; i < 16; ++i)
+        {
+            const float scale { 1.0f + static_cast<float>(i % 8) * 0.3f };
+
+            FAIL_IF(!animated.render(rnd, { 0.0f, 0.0f }, scale), "Could not render animated SDF text at scale ", scale);
+        }
+
+        return EXIT_SUCCESS;
+    }
+
+    // Caching glyphs of several fonts on worker threads.
+    int font_warmup()
+    {
+        using namespace std::string_view_literals;
+
+        FAIL_IF(hal::ttf::charset::ascii().size() != 95, "ASCII character set size mismatch");
+        FAIL_IF(hal::ttf::charset::latin1().size() != 95 + 96, "Latin-1 character set size mismatch");
+
+        constexpr std::array strings { "h\u00E9llo"sv, "hey"sv };
+
+        FAIL_IF(hal::ttf::charset::from(strings) != U"ehloy\u00E9", "Character set from strings mismatch");
+
+        hal::ttf::context        ctx;
+        hal::fs::resource_loader rl;
+
+        const hal::font_face face { rl.access("assets/m5x7.ttf") };
+        const hal::font      small { ctx.make_font(face, 16) }, large { ctx.make_font(face, 48) };
+
+        const std::array<hal::ref<const hal::font>, 2> fonts { small, large };
+
+        hal::thread_pool pool { 2 };
+
+        std::vector<std::future<std::size_t>> done { hal::ttf::warm_up(fonts, hal::ttf::charset::ascii(), pool) };
+
+        FAIL_IF(done.size() != fonts.size(), "Warmup task count mismatch");
+
+        const std::size_t cached { done[0].get() };
+
+        FAIL_IF(cached == 0, "No glyphs cached");
+        FAIL_IF(done[1].get() != cached, "Fonts of the same face cached different glyphs");
+
+        return EXIT_SUCCESS;
+    }
+
+    // Editing text objects in place.
+    int text_editing()
+    {
+        hal::ttf::context        ctx;
+        hal::fs::resource_loader rl;
+        hal::font                f { ctx.make_font(rl.access("assets/m5x7.ttf"), 24) };
+
+        hal::text t { f, "abc" };
+
+        const hal::pixel_t width { t.size().get().x };
+
+        FAIL_IF(!t.append("def") || t.str() != "abcdef", "Append mismatch (actual \"", t.str(), "\")");
+        FAIL_IF(t.size().get().x <= width, "Text not laid out again after appending");
+
+        FAIL_IF(!t.insert(3, "-") || t.str() != "abc-def", "Insert mismatch (actual \"", t.str(), "\")");
+        FAIL_IF(!t.erase(0, 4) || t.str() != "def", "Erase mismatch (actual \"", t.str(), "\")");
+        FAIL_IF(!t.erase(1) || t.str() != "d", "Erase to end mismatch (actual \"", t.str(), "\")");
+        FAIL_IF(!t.set("xyz") || t.str() != "xyz", "Set mismatch (actual \"", t.str(), "\")");
+
+        const hal::color c { hal::colors::orange, 128 };
+
+        FAIL_IF(!t.color(c) || t.color().get() != c, "Text color mismatch");
+        FAIL_IF(!t.wrap_width(100) || t.wrap_width().get() != 100, "Wrap width mismatch");
+
+        return EXIT_SUCCESS;
+    }
+
+    // Target guards restoring whatever was set before them.
+    int target_guard()
+    {
+        hal::cleanup_init<hal::subsystem::video> vid;
+
+        hal::window   wnd { vid, "HalTest: Target guard", { 640, 480 }, hal::window::flag::hidden };
+        hal::renderer rnd { wnd };
+
+        hal::target_texture outer { rnd, { 8, 8 }, hal::pixel::format::rgba32 };
+        hal::target_texture inner { rnd, { 2, 2 }, hal::pixel::format::rgba32 };
+
+        {
+            hal::guard::target _ { rnd, outer };
+
+            {
+                hal::guard::target __ { rnd, inner };
+
+                FAIL_IF((rnd.read_pixels().size() != hal::pixel::point { 2, 2 }), "Nested target not set");
+            }
+
+            FAIL_IF((rnd.read_pixels().size() != hal::pixel::point { 8, 8 }), "Nested guard did not restore the previous target");
+
+            // Only remembering the target, which is then changed by other means.
+            {
+                hal::guard::target __ { rnd };
+                rnd.target(inner);
+            }
+
+            FAIL_IF((rnd.read_pixels().size() != hal::pixel::point { 8, 8 }), "Restore-only guard did not restore the previous target");
+
+            // A previous target that's gone by then can't be restored; the window is.
+            {
+                hal::target_texture temp { rnd, { 4, 4 }, hal::pixel::format::rgba32 };
+                rnd.target(temp);
+
+                hal::guard::target __ { rnd, inner };
+                temp.reset();
+            }
+
+            FAIL_IF(::SDL_GetRenderTarget(rnd.get()) != nullptr, "Window not restored in place of a destroyed target");
+        }
+
+        FAIL_IF(::SDL_GetRenderTarget(rnd.get()) != nullptr, "Outermost guard did not restore the window");
+
+        return EXIT_SUCCESS;
+    }
+
+    // Counting draw calls and state changes, if enabled.
+    int renderer_stats()
+    {
+        hal::cleanup_init<hal::subsystem::video> vid;
+
+        hal::window   wnd { vid, "HalTest: Renderer statistics", { 640, 480 }, hal::window::flag::hidden };
+        hal::renderer rnd { wnd };
+
+        hal::target_texture tex { rnd, { 4, 4 }, hal::pixel::format::rgba32 };
+
+        rnd.reset_stats();
+
+        rnd.target(tex);
+        rnd.fill(hal::coord::rect { 0, 0, 2, 2 });
+        rnd.draw(std::array { hal::coord::point { 0, 0 }, hal::coord::point { 1, 1 }, hal::coord::point { 2, 2 } });
+        rnd.reset_target();
+
+        rnd.draw(tex).render();
+        rnd.draw(tex).render();
+
+        rnd.present();
+
+        const hal::renderer::statistics st { rnd.stats() };
+
+        if constexpr (hal::compile_settings::renderer_stats)
+        {
+            FAIL_IF(st.draw_calls != 4, "Draw call count mismatch (actual ", st.draw_calls, ')');
+            FAIL_IF(st.primitives != 6, "Primitive count mismatch (actual ", st.primitives, ')');
+            FAIL_IF(st.texture_binds != 1, "Texture bind count mismatch (actual ", st.texture_binds, ')');
+            FAIL_IF(st.target_switches != 2, "Target switch count mismatch (actual ", st.target_switches, ')');
+            FAIL_IF(st.presents != 1, "Present count mismatch");
+        }
+
+        else
+            FAIL_IF(st.draw_calls != 0 || st.presents != 0, "Statistics gathered despite being disabled");
+
+        rnd.reset_stats();
+
+        FAIL_IF(rnd.stats().draw_calls != 0, "Statistics not reset");
+
+        if constexpr (hal::compile_settings::renderer_stats)
+        {
+            // Only the updated area counts, however long the source's rows are.
+            hal::static_texture small { rnd, { 4, 4 }, hal::pixel::format::rgba32 };
+            const hal::surface  wide { { 256, 4 }, hal::pixel::format::rgba32 };
+
+            small.update(wide, hal::pixel::rect { 0, 0, 2, 2 });
+
+            // Setting the current target again isn't a switch.
+            rnd.target(tex);
+            rnd.target(tex);
+            rnd.reset_target();
+
+            FAIL_IF(rnd.stats().bytes_uploaded != 2 * 2 * 4, "Uploaded byte count mismatch (actual ", rnd.stats().bytes_uploaded, ')');
+            FAIL_IF(rnd.stats().target_switches != 2, "Redundant target switch counted");
+        }
+
+        return EXIT_SUCCESS;
+    }
+
+    // Discarding draws outside of the visible area.
+    int culling()
+    {
+        hal::cleanup_init<hal::subsystem::video> vid;
+
+        hal::window   wnd { vid, "HalTest: Culling", { 640, 480 }, hal::window::flag::hidden };
+        hal::renderer rnd { wnd };
+
+        hal::target_texture tex { rnd, { 4, 4 }, hal::pixel::format::rgba32 };
+
+        const hal::coord::rect visible { 0, 0, 640, 480 };
+
+        hal::command_buffer buf { rnd };
+
+        buf.cull(visible);
+
+        buf.fill({ 10, 10, 10, 10 });
+        buf.fill({ 700, 10, 10, 10 });
+        buf.draw({ -50, -50 }, { -10, -10 });
+        buf.draw(tex).to({ -2, -2 }).render();
+        buf.draw(tex).to({ 1000, 1000 }).render();
+        buf.draw(tex).to(hal::tag::fill).render();
+
+        FAIL_IF(buf.size() != 3, "Command count mismatch (actual ", buf.size(), ')');
+
+        // The copyer reports success for culled draws.
+        FAIL_IF(!rnd.draw(tex).to({ -100, -100 }).cull(visible).render(), "Culled copy failed");
+        FAIL_IF(!rnd.draw(tex).to({ 1000, 1000 }).cull().rotated(45.0, hal::flip::none), "Culled rotated copy failed");
+
+        FAIL_IF(!rnd.visible_area().valid(), "Could not get visible area");
+
+        return EXIT_SUCCESS;
+    }
+
+    // Comparing spatial index queries against a linear search.
+    int spatial_index()
+    {
+        hal::spatial_grid<int> grid { 32.0f };
+        hal::quadtree<int>     tree { { 0.0f, 0.0f, 512.0f, 512.0f }, 4 };
+
+        std::vector<hal::coord::rect> areas;
+
+        for (int i { 0 }; i < 400; ++i)
+        {
+            // Deterministic scatter, partially outside of the quadtree's bounds.
+            const hal::coord::rect r { static_cast<hal::coord_t>(i * 37 % 600) - 40.0f, static_cast<hal::coord_t>(i * 91 % 600) - 40.0f, static_cast<hal::coord_t>(i % 50), static_cast<hal::coord_t>(i % 23) };
+
+            areas.push_back(r);
+
+            FAIL_IF(grid.insert(r, i) != tree.insert(r, i), "Handle mismatch");
+        }
+
+        for (std::uint32_t h { 0 }; h < areas.size(); h += 5)
+        {
+            areas[h].pos += { 13.0f, -7.0f };
+
+            grid.move(h, areas[h]);
+            tree.move(h, areas[h]);
+        }
+
+        for (std::uint32_t h { 1 }; h < areas.size(); h += 9)
+        {
+            grid.remove(h);
+            tree.remove(h);
+        }
+
+        FAIL_IF(grid.size() != tree.size(), "Size mismatch");
+
+        for (std::uint32_t h { 0 }; h < areas.size(); ++h)
+            FAIL_IF(grid.contains(h) != tree.contains(h), "Handle ", h, " contained in only one index");
+
+        const hal::coord::rect  query_area { 100.0f, 50.0f, 200.0f, 120.0f };
+        const hal::coord::point query_point { 250.0f, 250.0f };
+
+        std::vector<std::uint32_t> expected, from_grid, from_tree;
+
+        for (std::uint32_t h { 0 }; h < areas.size(); ++h)
+        {
+            if (grid.contains(h) && (areas[h] | query_area))
+                expected.push_back(h);
+        }
+
+        grid.query(query_area, [&](std::uint32_t h)
+            { from_grid.push_back(h); });
+
+        tree.query(query_area, [&](std::uint32_t h)
+            { from_tree.push_back(h); });
+
+        std::ranges::sort(from_grid);
+        std::ranges::sort(from_tree);
+
+        FAIL_IF(expected.empty(), "Query area is empty");
+        FAIL_IF(from_grid != expected, "Grid area query mismatch");
+        FAIL_IF(from_tree != expected, "Quadtree area query mismatch");
+
+        expected.clear();
+        from_grid.clear();
+        from_tree.clear();
+
+        for (std::uint32_t h { 0 }; h < areas.size(); ++h)
+        {
+            if (grid.contains(h) && (query_point | areas[h]))
+                expected.push_back(h);
+        }
+
+        grid.query(query_point, [&](std::uint32_t h)
+            { from_grid.push_back(h); });
+
+        tree.query(query_point, [&](std::uint32_t h)
+            { from_tree.push_back(h); });
+
+        std::ranges::sort(from_grid);
+        std::ranges::sort(from_tree);
+
+        FAIL_IF(from_grid != expected, "Grid point query mismatch");
+        FAIL_IF(from_tree != expected, "Quadtree point query mismatch");
+
+        return EXIT_SUCCESS;
+    }
+
+    // Comparing batch transforms against their scalar counterparts.
+    int batch_transforms()
+    {
+        // An odd amount, so that the SIMD paths' remainders get tested too.
+        std::array<hal::coord::rect, 7> rects;
+
+        for (std::size_t i { 0 }; i < rects.size(); ++i)
+            rects[i] = { static_cast<hal::coord_t>(i) * 10.0f - 30.0f, 5.0f - static_cast<hal::coord_t>(i), 4.0f + static_cast<hal::coord_t>(i), 6.0f };
+
+        const std::array original { rects };
+
+        hal::batch::anchor(rects, hal::anchor::center);
+
+        for (std::size_t i { 0 }; i < rects.size(); ++i)
+            FAIL_IF(rects[i].pos != original[i].pos.anchor(hal::anchor::center, original[i].size), "Anchor mismatch at index ", i);
+
+        rects = original;
+        hal::batch::translate(rects, { 2.0f, -3.0f });
+        hal::batch::scale(rects, { 2.0f, 2.0f });
+
+        for (std::size_t i { 0 }; i < rects.size(); ++i)
+        {
+            const hal::coord::point pos { (original[i].pos + hal::coord::point { 2.0f, -3.0f }) * 2.0f };
+            FAIL_IF(rects[i].pos != pos || rects[i].size != original[i].size * 2.0f, "Translate/scale mismatch at index ", i);
+        }
+
+        // A 90-degree rotation maps a rectangle onto another axis-aligned one.
+        rects = original;
+        hal::batch::affine(rects, { .xx = 0.0f, .xy = 1.0f, .yx = -1.0f, .yy = 0.0f, .tx = 0.0f, .ty = 0.0f });
+
+        for (std::size_t i { 0 }; i < rects.size(); ++i)
+        {
+            const hal::coord::rect& o { original[i] };
+            const hal::coord::rect  expected { -(o.pos.y + o.size.y), o.pos.x, o.size.y, o.size.x };
+
+            FAIL_IF(rects[i] != expected, "Affine mismatch at index ", i, " (actual ", rects[i], ", expected ", expected, ')');
+        }
+
+        const hal::coord::rect area { 0.0f, 0.0f, 20.0f, 20.0f };
+
+        std::array<bool, 7> hits;
+
+        const std::size_t count { hal::batch::intersect(original, area, hits) };
+
+        std::size_t expected_count { 0 };
+
+        for (std::size_t i { 0 }; i < original.size(); ++i)
+        {
+            FAIL_IF(hits[i] != (original[i] | area), "Intersection mismatch at index ", i);
+            expected_count += hits[i];
+        }
+
+        FAIL_IF(count != expected_count, "Intersection count mismatch");
+
+        return EXIT_SUCCESS;
+    }
+
+    // Drawing sprites from an atlas in a single call.
+    int sprite_batch()
+    {
+        hal::cleanup_init<hal::subsystem::video> vid;
+
+        hal::window   wnd { vid, "HalTest: Sprite batch", { 640, 480 }, hal::window::flag::hidden };
+        hal::renderer rnd { wnd };
+
+        // Left half red, right half blue.
+        hal::surface atlas { { 4, 2 } };
+        atlas.fill({ 0, 0, 2, 2 }, hal::colors::red);
+        atlas.fill({ 2, 0, 2, 2 }, hal::colors::blue);
+
+        const hal::static_texture tex { rnd, atlas };
+        hal::target_texture       target { rnd, { 8, 8 }, hal::pixel::format::rgba32 };
+
+        hal::sprite_batch batch { tex };
+
+        const hal::sprite_batch::index_t red { batch.add_source({ 0, 0, 2, 2 }) };
+        const hal::sprite_batch::index_t blue { batch.add_source({ 2, 0, 2, 2 }) };
+
+        batch.add({ 0.0f, 0.0f, 4.0f, 4.0f }, red);
+        batch.add({ 4.0f, 4.0f, 4.0f, 4.0f }, blue);
+        batch.add({ 100.0f, 100.0f, 4.0f, 4.0f }, blue);
+
+        batch.cull({ 0.0f, 0.0f, 8.0f, 8.0f });
+
+        std::vector<hal::vertex> vertices;
+        std::vector<int>         indices;
+
+        FAIL_IF(batch.build(vertices, indices) != 2, "Off-screen sprite not culled");
+        FAIL_IF(vertices.size() != 8 || indices.size() != 12, "Vertex/index count mismatch");
+
+        {
+            hal::guard::target _ { rnd, target };
+
+            rnd.color(hal::colors::black);
+            rnd.clear();
+
+            FAIL_IF(!batch.render(rnd), "Could not render sprite batch");
+
+            const hal::surface s { rnd.read_pixels() };
+
+            FAIL_IF(s.pixel({ 1, 1 }).get() != hal::colors::red, "Red sprite not drawn");
+            FAIL_IF(s.pixel({ 6, 6 }).get() != hal::colors::blue, "Blue sprite not drawn");
+            FAIL_IF(s.pixel({ 6, 1 }).get() != hal::colors::black, "Drew outside of sprites");
+        }
+
+        batch.remove(0);
+
+        FAIL_IF(batch.size() != 2 || batch.sources()[0] != blue, "Removal did not move the last sprite");
+
+        return EXIT_SUCCESS;
+    }
+
+    // Redrawing a cached layer only when invalidated.
+    int cached_layer()
+    {
+        hal::cleanup_init<hal::subsystem::video> vid;
+
+        hal::window   wnd { vid, "HalTest: Cached layer", { 640, 480 }, hal::window::flag::hidden };
+        hal::renderer rnd { wnd };
+
+        hal::target_texture screen { rnd, { 8, 8 }, hal::pixel::format::rgba32 };
+        hal::cached_layer   layer { rnd, { 4, 4 } };
+
+        int redraws { 0 };
+
+        const auto contents = [&](hal::renderer& r)
+        {
+            ++redraws;
+            r.fill({ 0, 0, 4, 4 }, hal::colors::green);
+        };
+
+        hal::guard::target _ { rnd, screen };
+
+        for (int i { 0 }; i < 3; ++i)
+            FAIL_IF(!layer.render({ 2.0f, 2.0f }, contents), "Could not render layer");
+
+        FAIL_IF(redraws != 1, "Layer redrawn without being invalidated");
+
+        layer.invalidate();
+
+        FAIL_IF(!layer.render({ 2.0f, 2.0f }, contents), "Could not render layer");
+        FAIL_IF(redraws != 2, "Invalidated layer not redrawn");
+
+        // The layer restores the previous target, so this reads the "screen".
+        const hal::surface s { rnd.read_pixels() };
+
+        FAIL_IF((s.size() != hal::pixel::point { 8, 8 }), "Previous render target not restored");
+        FAIL_IF(s.pixel({ 3, 3 }).get() != hal::colors::green, "Layer not drawn");
+
+        return EXIT_SUCCESS;
+    }
+
+    // Drawing only the visible chunks of a tile map.
+    int tilemap()
+    {
+        hal::cleanup_init<hal::subsystem::video> vid;
+
+        hal::window   wnd { vid, "HalTest: Tile map", { 640, 480 }, hal::window::flag::hidden };
+        hal::renderer rnd { wnd };
+
+        // Tile 0 is red, tile 1 is blue.
+        hal::surface tileset { { 4, 2 } };
+        tileset.fill({ 0, 0, 2, 2 }, hal::colors::red);
+        tileset.fill({ 2, 0, 2, 2 }, hal::colors::blue);
+
+        const hal::static_texture tex { rnd, tileset };
+        hal::target_texture       screen { rnd, { 8, 8 }, hal::pixel::format::rgba32 };
+
+        // 8x8 tiles of 2x2 pixels, in 4x4 chunks of 2x2 tiles.
+        hal::tilemap map { rnd, tex, { 2, 2 }, { 8, 8 }, 2 };
+
+        map.set({ 0, 0 }, 0);
+        map.set({ 3, 3 }, 1);
+
+        FAIL_IF(map.get({ 3, 3 }) != 1 || map.get({ 1, 0 }) != hal::tilemap::empty, "Tile mismatch");
+
+        hal::guard::target _ { rnd, screen };
+
+        rnd.color(hal::colors::black);
+        rnd.clear();
+
+        FAIL_IF(!map.render({ 0.0f, 0.0f, 8.0f, 8.0f }), "Could not render tile map");
+        FAIL_IF(map.baked_chunks() != 4, "Baked chunks outside of view");
+
+        hal::surface s { rnd.read_pixels() };
+
+        FAIL_IF(s.pixel({ 1, 1 }).get() != hal::colors::red, "Red tile not drawn");
+        FAIL_IF(s.pixel({ 6, 6 }).get() != hal::colors::blue, "Blue tile not drawn");
+        FAIL_IF(s.pixel({ 4, 1 }).get() != hal::colors::black, "Drew an empty tile");
+
+        // Changing a tile rebakes its chunk; scrolling moves the map.
+        map.set({ 3, 3 }, 0);
+        rnd.clear();
+
+        FAIL_IF(!map.render({ 2.0f, 2.0f, 8.0f, 8.0f }), "Could not render tile map");
+
+        s = rnd.read_pixels();
+
+        FAIL_IF(s.pixel({ 4, 4 }).get() != hal::colors::red, "Changed tile not redrawn");
+
+        // Far-away chunks replace the least recently used ones.
+        map.max_baked_chunks(4);
+
+        FAIL_IF(!map.render({ 8.0f, 8.0f, 8.0f, 8.0f }), "Could not render tile map");
+        FAIL_IF(map.baked_chunks() != 4, "Chunks not evicted");
+
         return EXIT_SUCCESS;
     }
 
@@ -409,6 +1543,30 @@ int main(int argc, char* argv[])
         test { "--invalid-buffer", invalid_buffer },
         test { "--invalid-texture", invalid_texture },
         test { "--text-engines", text_engines },
+        test { "--dirty-region", dirty_region },
+        test { "--command-buffer", command_buffer },
+        test { "--thread-pool", thread_pool },
+        test { "--renderer-stats", renderer_stats },
+        test { "--culling", culling },
+        test { "--spatial-index", spatial_index },
+        test { "--batch-transforms", batch_transforms },
+        test { "--sprite-batch", sprite_batch },
+        test { "--cached-layer", cached_layer },
+        test { "--tilemap", tilemap },
+        test { "--parallel-blit", parallel_blit },
+        test { "--resample", resample },
+        test { "--mip-texture", mip_texture },
+        test { "--fast-convert", fast_convert },
+        test { "--capture-queue", capture_queue },
+        test { "--frame-recorder", frame_recorder },
+        test { "--parallel-qoi", parallel_qoi },
+        test { "--tiled-texture", tiled_texture },
+        test { "--image-sniff", image_sniff },
+        test { "--font-face", font_face },
+        test { "--sdf-text", sdf_text },
+        test { "--font-warmup", font_warmup },
+        test { "--text-editing", text_editing },
+        test { "--target-guard", target_guard },
 #ifdef HAL_DEBUG_ENABLED
         test { "--assert-fail", assert_fail },
         test { "--invalid-event", invalid_event },